@@ -7,14 +7,28 @@
 QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+CONFIG += c++11
 
 TARGET = brams_waterfall
 TEMPLATE = app
 INCLUDEPATH += D:\oragelac\Softwares\fftw
 LIBS += -LD:\oragelac\Softwares\fftw -lfftw3-3
 
+# let the per-column loops vectorize
+gcc: QMAKE_CXXFLAGS_RELEASE += -O3
+
 SOURCES += \
     tcpclient.cpp \
+    ricedecoder.cpp \
+    decimator.cpp \
+    columnserver.cpp \
+    columnclient.cpp \
+    history.cpp \
+    exporter.cpp \
+    bramsfile.cpp \
+    fileview.cpp \
+    tonetracker.cpp \
+    tonestrip.cpp \
     fft.cpp \
     main.cpp \
     mainwindow.cpp \
@@ -23,6 +37,17 @@ SOURCES += \
 
 HEADERS  += \
     tcpclient.h \
+    ricedecoder.h \
+    decimator.h \
+    fastlog.h \
+    columnserver.h \
+    columnclient.h \
+    history.h \
+    exporter.h \
+    bramsfile.h \
+    fileview.h \
+    tonetracker.h \
+    tonestrip.h \
     fft.h \
     mainwindow.h \
     palette.h \
@@ -0,0 +1,103 @@
+#include "bramsfile.h"
+
+static quint32 readUInt32(const uchar *p) {
+
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((quint32) p[3] << 24);
+}
+
+BramsFile::BramsFile() : samples(0), count(0), rate(0), start(0) {}
+
+BramsFile::~BramsFile() {
+
+    file.close();
+}
+
+/* Walks the RIFF chunks, taking the sample rate from BRA1 when present and
+ * from the fmt chunk otherwise, and maps the data chunk. */
+bool BramsFile::open(QString path) {
+
+    file.setFileName(path);
+
+    if(!file.open(QIODevice::ReadOnly) || file.size() < 12) {
+
+        std::cout << "cannot open " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    const uchar *map = file.map(0, file.size());
+
+    if(!map || memcmp(map, "RIFF", 4) != 0 || memcmp(map + 8, "WAVE", 4) != 0) {
+
+        std::cout << path.toStdString() << " is not a WAV file" << std::endl;
+        return false;
+    }
+
+    qint64 offset = 12;
+
+    while(offset + 8 <= file.size()) {
+
+        const uchar *chunk = map + offset;
+        qint64 size = readUInt32(chunk + 4);
+
+        if(offset + 8 + size > file.size()) {
+
+            size = file.size() - offset - 8;
+        }
+
+        if(memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && rate == 0) {
+
+            rate = readUInt32(chunk + 12);
+        }
+
+        else if(memcmp(chunk, "BRA1", 4) == 0 && size >= 26) {
+
+            memcpy(&rate, chunk + 8 + 2, sizeof(double));
+            memcpy(&start, chunk + 8 + 18, sizeof(quint64));
+        }
+
+        else if(memcmp(chunk, "data", 4) == 0) {
+
+            samples = (const int16_t *) (chunk + 8);
+            count = size / sizeof(int16_t);
+        }
+
+        offset += 8 + size + (size & 1);
+    }
+
+    return samples && rate > 0;
+}
+
+qint64 BramsFile::length() const {
+
+    return count;
+}
+
+double BramsFile::sampleRate() const {
+
+    return rate;
+}
+
+/* Microseconds since epoch of the first sample, 0 without a BRA1 header. */
+quint64 BramsFile::startTime() const {
+
+    return start;
+}
+
+/* Copies `n` samples from `offset`, zero padded outside the recording. */
+void BramsFile::read(qint64 offset, int n, double *out) const {
+
+    for(int i = 0; i < n; ++i) {
+
+        qint64 j = offset + i;
+        out[i] = j >= 0 && j < count ? samples[j] : 0;
+    }
+}
+
+void BramsFile::read(qint64 offset, int n, float *out) const {
+
+    for(int i = 0; i < n; ++i) {
+
+        qint64 j = offset + i;
+        out[i] = j >= 0 && j < count ? samples[j] : 0;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef BRAMSFILE_H
+#define BRAMSFILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <QFile>
+#include <QString>
+
+/* Read-only, memory mapped BRAMS WAV recording (see bramsriff.py for the
+ * layout of the BRA1 subchunk). */
+class BramsFile {
+
+public:
+
+    BramsFile();
+    ~BramsFile();
+
+    bool open(QString);
+
+    qint64 length() const;
+    double sampleRate() const;
+    quint64 startTime() const;
+
+    void read(qint64, int, double*) const;
+    void read(qint64, int, float*) const;
+
+private:
+
+    QFile file;
+    const int16_t *samples;
+    qint64 count;
+    double rate;
+    quint64 start;
+};
+
+#endif // BRAMSFILE_H
@@ -126,6 +126,74 @@ class BRAMSData:
                  (self.signal == signal_min)).sum()))
 
 
+class BRAMSCompressor:
+    """
+    Lossless block coder for the sample stream, decoded by RiceDecoder.
+
+    Each block carries its first two samples raw, then the residuals of the
+    best fixed polynomial predictor (order 0 to 2), zigzag mapped and Rice
+    coded. Blocks are independent, so a receiver can start at any block.
+    """
+
+    magic = b"BRZ1"
+    fmt = "<HBBHhh"
+    escape = 24
+    escape_bits = 20
+
+    def encode(self, samples):
+        x = [int(v) for v in samples]
+        n = len(x)
+
+        residuals = None
+        for order in range(3):
+            if order == 0:
+                e = x[2:]
+            elif order == 1:
+                e = [x[i] - x[i - 1] for i in range(2, n)]
+            else:
+                e = [x[i] - 2 * x[i - 1] + x[i - 2] for i in range(2, n)]
+            cost = sum(abs(v) for v in e)
+            if residuals is None or cost < best:
+                best, best_order, residuals = cost, order, e
+
+        u = [2 * v if v >= 0 else -2 * v - 1 for v in residuals]
+        k = self.parameter(u)
+
+        bits = []
+        for v in u:
+            q = v >> k
+            if q < self.escape:
+                bits.append("1" * q + "0")
+                if k:
+                    bits.append(format(v & ((1 << k) - 1), "0{}b".format(k)))
+            else:
+                bits.append("1" * self.escape)
+                bits.append(format(v, "0{}b".format(self.escape_bits)))
+        bits = "".join(bits)
+        bits += "0" * (-len(bits) % 8)
+        payload = int(bits, 2).to_bytes(len(bits) // 8, "big") if bits else b""
+
+        return self.magic + struct.pack(
+            self.fmt, n, best_order, k, len(payload), x[0], x[1]) + payload
+
+    def parameter(self, u):
+        """
+        Rice parameter with the smallest coded size, searched around
+        log2 of the mean residual.
+        """
+        if not u:
+            return 0
+        guess = max(0, int(sum(u) / len(u)).bit_length() - 1)
+        best = None
+        for k in range(max(0, guess - 1), min(20, guess + 2) + 1):
+            size = sum(
+                (v >> k) + 1 + k if (v >> k) < self.escape
+                else self.escape + self.escape_bits for v in u)
+            if best is None or size < best[0]:
+                best = (size, k)
+        return best[1]
+
+
 class WAVFile:
 
     def __init__(self, filename):
@@ -199,6 +267,9 @@ if __name__ == "__main__":
     parser.add_argument(
         "-s", "--show", help="print chunk and subchunk info",
         action="store_true")
+    parser.add_argument(
+        "-c", "--compress", help="send Rice coded blocks of samples",
+        action="store_true")
     args = parser.parse_args()
 
     # print(args)
@@ -216,6 +287,24 @@ if __name__ == "__main__":
 
         client, address = server.accept()
 
+        # preamble: magic, sample rate, flags (bit 0: compressed blocks)
+        rate = b.sample_rate if b else 5512.5
+        client.sendall(b"BRSR" + struct.pack(
+            "<dI", rate, 1 if args.compress else 0))
+
+        if args.compress:
+
+            compressor = BRAMSCompressor()
+            block = 1024
+
+            while True:
+
+                for i in range(0, len(data.signal) - 1, block):
+
+                    samples = data.signal[i:i + block]
+                    client.sendall(compressor.encode(samples))
+                    time.sleep(0.00005 * len(samples))
+
         while True:
 
             for sample in data.signal:
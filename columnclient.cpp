@@ -0,0 +1,143 @@
+#include "columnclient.h"
+
+ColumnClient::ColumnClient(int fftSize, double sampleRate, QString host, unsigned short int port) : socket(this), host(host), port(port), retryDelay(RECONNECT_DELAY), frameSize(fftSize / 2), bins(0), start(0), end(0), configured(false) {
+
+    df = sampleRate / fftSize;
+
+    frame = new double[frameSize];
+    binOf = new unsigned int[frameSize];
+
+    for(int i = 0; i < 256; ++i) {
+
+        magnitudes[i] = pow(10, i * COLUMN_DB_PER_STEP / 20);
+    }
+
+    socket.connectToHost(QHostAddress(host), port);
+    QObject::connect(&socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+    QObject::connect(&socket, SIGNAL(connected()), this, SLOT(connected()));
+    QObject::connect(&socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    QObject::connect(&socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(connectionError(QAbstractSocket::SocketError)));
+
+    reconnectTimer.setSingleShot(true);
+    QObject::connect(&reconnectTimer, SIGNAL(timeout()), this, SLOT(reconnect()));
+}
+
+ColumnClient::~ColumnClient() {
+
+    delete[] frame;
+    delete[] binOf;
+}
+
+void ColumnClient::connected() {
+
+    std::cout << "connected to " << host.toStdString() << ":" << port << std::endl;
+}
+
+/* A restarted server sends a new header, so the stream is parsed from scratch. */
+void ColumnClient::disconnected() {
+
+    std::cout << "disconnected, reconnecting" << std::endl;
+    configured = false;
+    byteArray.clear();
+
+    reconnectTimer.start(retryDelay);
+}
+
+/* Same retry policy as TcpClient: failed attempts only report an error. */
+void ColumnClient::connectionError(QAbstractSocket::SocketError) {
+
+    if(socket.state() == QAbstractSocket::UnconnectedState) {
+
+        std::cout << "connection failed: " << socket.errorString().toStdString() << ", retrying in " << retryDelay / 1000 << " s" << std::endl;
+        reconnectTimer.start(retryDelay);
+    }
+}
+
+void ColumnClient::reconnect() {
+
+    if(socket.state() != QAbstractSocket::UnconnectedState) {
+
+        return;
+    }
+
+    retryDelay = qMin(2 * retryDelay, RECONNECT_MAX_DELAY);
+    socket.connectToHost(QHostAddress(host), port);
+}
+
+/* Parses the stream header and maps every frame bin to the server bin covering it. */
+bool ColumnClient::readHeader() {
+
+    const int headerSize = 4 + sizeof(quint32) + 2 * sizeof(double);
+
+    if(byteArray.length() < headerSize) {
+
+        return false;
+    }
+
+    if(!byteArray.startsWith(COLUMN_MAGIC)) {
+
+        std::cout << "not a column server, closing" << std::endl;
+        socket.abort();
+        byteArray.clear();
+        return false;
+    }
+
+    QDataStream stream(byteArray);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.skipRawData(4);
+
+    quint32 count;
+    double freqFrom, freqTo;
+    stream >> count >> freqFrom >> freqTo;
+    byteArray.remove(0, headerSize);
+
+    bins = count;
+    start = freqFrom / df;
+    end = freqTo / df;
+    if(end > frameSize) end = frameSize;
+
+    double f = ((freqTo - freqFrom) / df) / bins;
+
+    for(unsigned int j = start; j < end; ++j) {
+
+        unsigned int k = (j - freqFrom / df) / f;
+        binOf[j] = k < bins ? k : bins - 1;
+    }
+
+    std::cout << "receiving " << bins << " bins from " << freqFrom << " to " << freqTo << " Hz" << std::endl;
+
+    memset(frame, 0, frameSize * sizeof(double));
+    configured = bins > 0;
+
+    /* only a real column server resets the backoff */
+    retryDelay = RECONNECT_DELAY;
+
+    return configured;
+}
+
+void ColumnClient::onReadyRead() {
+
+    byteArray.append(socket.readAll());
+
+    if(!configured && !readHeader()) {
+
+        return;
+    }
+
+    int offset = 0;
+
+    while(byteArray.length() - offset >= (int) bins) {
+
+        const unsigned char *column = (const unsigned char *) byteArray.constData() + offset;
+
+        for(unsigned int j = start; j < end; ++j) {
+
+            frame[j] = magnitudes[column[binOf[j]]];
+        }
+
+        offset += bins;
+        emit columnReady(frame);
+    }
+
+    byteArray.remove(0, offset);
+}
@@ -0,0 +1,60 @@
+#ifndef COLUMNCLIENT_H
+#define COLUMNCLIENT_H
+
+#include <cmath>
+#include <iostream>
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QDataStream>
+#include <QTimer>
+
+#include "columnserver.h"
+#include "tcpclient.h"
+
+/* Thin viewer side of ColumnServer: turns received columns back into
+ * magnitude frames laid out like FFT::done, so Spectrogram can draw them. */
+class ColumnClient : public QObject {
+
+    Q_OBJECT
+
+public slots:
+
+    void onReadyRead();
+    void connected();
+    void disconnected();
+    void connectionError(QAbstractSocket::SocketError);
+    void reconnect();
+
+signals:
+
+    void columnReady(double*);
+
+public:
+
+    ColumnClient(int, double, QString, unsigned short int);
+    ~ColumnClient();
+
+private:
+
+    bool readHeader();
+
+    QTcpSocket socket;
+    QByteArray byteArray;
+    QTimer reconnectTimer;
+    QString host;
+    unsigned short int port;
+    int retryDelay;
+
+    unsigned int frameSize, bins, start, end;
+    double df;
+    bool configured;
+
+    double magnitudes[256];
+    unsigned int *binOf;
+    double *frame;
+};
+
+#endif // COLUMNCLIENT_H
@@ -0,0 +1,131 @@
+#include "columnserver.h"
+
+ColumnServer::ColumnServer(unsigned short int port, int fftSize, double sampleRate, unsigned int bins, double freqFrom, double freqTo, unsigned int historyLength) : server(this), frameSize(fftSize / 2), bins(bins), historyLength(historyLength), historyCount(0), historyNext(0), freqFrom(freqFrom), freqTo(freqTo) {
+
+    df = sampleRate / fftSize;
+    passband = sampleRate / 2;
+
+    history = new unsigned char[(size_t) historyLength * bins];
+    column = new unsigned char[bins];
+
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(COLUMN_MAGIC, 4);
+    stream << (quint32) bins << freqFrom << freqTo;
+
+    QObject::connect(&server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+    if(server.listen(QHostAddress::Any, port)) {
+
+        std::cout << "serving columns on port " << port << std::endl;
+    }
+
+    else {
+
+        std::cout << "cannot listen on port " << port << ": " << server.errorString().toStdString() << std::endl;
+    }
+}
+
+ColumnServer::~ColumnServer() {
+
+    delete[] history;
+    delete[] column;
+}
+
+bool ColumnServer::isListening() const {
+
+    return server.isListening();
+}
+
+/* Averages the spectrum over `bins` bands of [freqFrom, freqTo] and quantizes the result. */
+void ColumnServer::reduce(double *data) {
+
+    double f = ((freqTo - freqFrom) / df) / bins;
+    double start = freqFrom / df;
+    double end = (freqTo < passband ? freqTo : passband) / df;
+    if(end > frameSize) end = frameSize;
+    float scale = (float) (20 * log10(2.0) / COLUMN_DB_PER_STEP);
+
+    for(unsigned int k = 0; k < bins; ++k) {
+
+        double m = 0;
+        int n = 0;
+
+        for(int j = start + (k * f); j < start + (k * f) + f; ++j) {
+
+            if(j >= 0 && j < end) {
+
+                m += data[j];
+                n++;
+            }
+        }
+
+        float value = n > 0 && m > 0 ? fastLog2(m / n) * scale : 0;
+
+        if(value < 0) value = 0;
+        if(value > 255) value = 255;
+
+        column[k] = (unsigned char) value;
+    }
+}
+
+void ColumnServer::publish(double *data) {
+
+    reduce(data);
+
+    memcpy(history + (size_t) historyNext * bins, column, bins);
+    historyNext = (historyNext + 1) % historyLength;
+    if(historyCount < historyLength) historyCount++;
+
+    for(int i = 0; i < clients.size(); ++i) {
+
+        /* a viewer that cannot keep up skips columns instead of growing our buffers */
+        if(clients[i]->bytesToWrite() < COLUMN_MAX_BACKLOG) {
+
+            clients[i]->write((const char *) column, bins);
+        }
+    }
+}
+
+/* Columns keep their frequency range, only the bins they average change.
+ * Above the decimator's passband they stay empty. */
+void ColumnServer::setSampleRate(double analysisRate, double inputRate) {
+
+    df = analysisRate / (2 * frameSize);
+    passband = Decimator::passband(inputRate, analysisRate);
+}
+
+void ColumnServer::newConnection() {
+
+    while(server.hasPendingConnections()) {
+
+        QTcpSocket *client = server.nextPendingConnection();
+        QObject::connect(client, SIGNAL(disconnected()), this, SLOT(clientDisconnected()));
+
+        std::cout << "viewer connected from " << client->peerAddress().toString().toStdString() << std::endl;
+
+        /* late joiners get the recent history, oldest column first */
+        client->write(header);
+
+        unsigned int first = (historyNext + historyLength - historyCount) % historyLength;
+
+        for(unsigned int i = 0; i < historyCount; ++i) {
+
+            client->write((const char *) history + (size_t) ((first + i) % historyLength) * bins, bins);
+        }
+
+        clients.append(client);
+    }
+}
+
+void ColumnServer::clientDisconnected() {
+
+    QTcpSocket *client = qobject_cast<QTcpSocket*>(sender());
+
+    if(client) {
+
+        std::cout << "viewer disconnected" << std::endl;
+        clients.removeAll(client);
+        client->deleteLater();
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef COLUMNSERVER_H
+#define COLUMNSERVER_H
+
+#include <cmath>
+#include <iostream>
+
+#include <QObject>
+#include <QList>
+#include <QByteArray>
+#include <QDataStream>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "decimator.h"
+#include "fastlog.h"
+
+#define COLUMN_MAGIC "BWC1"
+#define COLUMN_DB_PER_STEP 0.75
+#define COLUMN_MAX_BACKLOG (1 << 20)
+
+/* Serves reduced spectrogram columns to any number of viewers.
+ *
+ * Each viewer first receives a header (magic, number of bins, frequency range),
+ * then the recent history, then one column of `bins` bytes per spectrum. A byte
+ * is the bin magnitude in steps of COLUMN_DB_PER_STEP dB. */
+class ColumnServer : public QObject {
+
+    Q_OBJECT
+
+public slots:
+
+    void publish(double*);
+    void setSampleRate(double, double);
+
+private slots:
+
+    void newConnection();
+    void clientDisconnected();
+
+public:
+
+    ColumnServer(unsigned short int, int, double, unsigned int, double, double, unsigned int);
+    ~ColumnServer();
+
+    bool isListening() const;
+
+private:
+
+    void reduce(double*);
+
+    QTcpServer server;
+    QList<QTcpSocket*> clients;
+    QByteArray header;
+
+    unsigned int frameSize, bins, historyLength, historyCount, historyNext;
+    double df, freqFrom, freqTo, passband;
+
+    unsigned char *history;
+    unsigned char *column;
+};
+
+#endif // COLUMNSERVER_H
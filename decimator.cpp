@@ -0,0 +1,138 @@
+#include "decimator.h"
+
+static inline float dot(const float *a, const float *b, int n) {
+
+    int i = 0;
+    float sum = 0;
+
+#ifdef __SSE__
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+
+    for(; i + 8 <= n; i += 8) {
+
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for(; i < n; ++i) {
+
+        sum += a[i] * b[i];
+    }
+
+    return sum;
+}
+
+/* Modified Bessel function of the first kind, order 0, for the Kaiser window. */
+static double besselI0(double x) {
+
+    double sum = 1, term = 1;
+
+    for(int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+Decimator::Decimator(double inputRate, double targetRate) {
+
+    d = inputRate > targetRate ? (int) floor(inputRate / targetRate + 1e-9) : 1;
+    rate = inputRate / d;
+    taps = d > 1 ? d * DECIMATOR_TAPS_PER_PHASE : 1;
+
+    /* h(i) = 2 fc sinc(2 fc (i - (L-1)/2)) * kaiser(i), normalized to unit
+     * gain, with fc in the middle of the transition band */
+    coefficients = new float[taps];
+    double fc = (DECIMATOR_PASSBAND + DECIMATOR_STOPBAND) / 2 / d;
+    double sum = 0;
+
+    for(int i = 0; i < taps; ++i) {
+
+        double x = i - (taps - 1) / 2.0;
+        double r = taps > 1 ? 2.0 * i / (taps - 1) - 1 : 0;
+        double sinc = x == 0 ? 2 * fc : sin(2 * M_PI * fc * x) / (M_PI * x);
+        double window = besselI0(DECIMATOR_KAISER_BETA * sqrt(1 - r * r)) / besselI0(DECIMATOR_KAISER_BETA);
+        coefficients[i] = sinc * window;
+        sum += coefficients[i];
+    }
+
+    for(int i = 0; i < taps; ++i) {
+
+        coefficients[i] /= sum;
+    }
+}
+
+Decimator::~Decimator() {
+
+    delete[] coefficients;
+}
+
+int Decimator::factor() const {
+
+    return d;
+}
+
+int Decimator::length() const {
+
+    return taps;
+}
+
+double Decimator::outputRate() const {
+
+    return rate;
+}
+
+/* Highest frequency shown flat after decimating `inputRate` to `outputRate`. */
+double Decimator::passband(double inputRate, double outputRate) {
+
+    return outputRate < inputRate ? DECIMATOR_PASSBAND * outputRate : outputRate / 2;
+}
+
+/* Streaming: appends the decimated samples of `n` new input samples to `out`. */
+void Decimator::process(const int16_t *samples, int n, QVector<double> &out) {
+
+    if(d == 1) {
+
+        for(int i = 0; i < n; ++i) {
+
+            out.append(samples[i]);
+        }
+
+        return;
+    }
+
+    int previous = buffer.size();
+    buffer.resize(previous + n);
+
+    for(int i = 0; i < n; ++i) {
+
+        buffer[previous + i] = samples[i];
+    }
+
+    int outputs = buffer.size() >= taps ? (buffer.size() - taps) / d + 1 : 0;
+
+    if(outputs > 0) {
+
+        int start = out.size();
+        out.resize(start + outputs);
+        decimate(buffer.constData(), outputs, out.data() + start);
+        buffer.remove(0, outputs * d);
+    }
+}
+
+/* Stateless: `in` holds (outputs - 1) * factor() + length() input samples. */
+void Decimator::decimate(const float *in, int outputs, double *out) const {
+
+    for(int m = 0; m < outputs; ++m) {
+
+        out[m] = dot(coefficients, in + (size_t) m * d, taps);
+    }
+}
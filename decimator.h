@@ -0,0 +1,53 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cmath>
+#include <cstdint>
+
+#include <QVector>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#define DECIMATOR_TAPS_PER_PHASE 112
+#define DECIMATOR_PASSBAND 0.45     // of the output sample rate, flat within 0.001 dB
+#define DECIMATOR_STOPBAND 0.5      // of the output sample rate, 81 dB down from there
+#define DECIMATOR_KAISER_BETA 7.86
+
+/* Brings a high rate stream down to the analysis band ahead of FFT.
+ *
+ * The factor is the largest integer keeping the output rate at or above the
+ * target. The low-pass is a Kaiser windowed sinc of DECIMATOR_TAPS_PER_PHASE
+ * taps per phase, with its transition between DECIMATOR_PASSBAND and
+ * DECIMATOR_STOPBAND: nothing aliases into the output band, but only the
+ * band below passband() is flat, and displays should stop there. Only every
+ * factor-th output is computed, so the cost per output sample is that of one
+ * phase set, a contiguous dot product done four lanes at a time with SSE.
+ * With a factor of 1 samples are passed through unfiltered. */
+class Decimator {
+
+public:
+
+    Decimator(double, double);
+    ~Decimator();
+
+    int factor() const;
+    int length() const;
+    double outputRate() const;
+
+    static double passband(double, double);
+
+    void process(const int16_t*, int, QVector<double>&);
+    void decimate(const float*, int, double*) const;
+
+private:
+
+    int d, taps;
+    double rate;
+
+    float *coefficients;
+    QVector<float> buffer;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,213 @@
+#include "exporter.h"
+
+Exporter::Exporter(const HistorySnapshot &snapshot, QString path, double freqFrom, double freqTo) : snapshot(snapshot), path(path) {
+
+    start = freqFrom / snapshot.df;
+    end = freqTo / snapshot.df;
+
+    if(end > snapshot.bins) end = snapshot.bins;
+    if(start > end) start = end;
+
+    setAutoDelete(false);
+}
+
+void Exporter::run() {
+
+    bool ok = snapshot.columns > 0 && end > start;
+
+    if(ok) {
+
+        ok = path.endsWith(".npy", Qt::CaseInsensitive) ? writeNpy() : writePng();
+    }
+
+    emit finished(path, ok);
+}
+
+/* QPainter cannot draw on indexed images: the axes are drawn in white on
+ * black RGB strips without antialiasing, then copied in as the two margin
+ * color indices. */
+static void pasteMargin(const QImage &strip, QImage &image, int x, int y) {
+
+    for(int j = 0; j < strip.height(); ++j) {
+
+        const QRgb *from = (const QRgb *) strip.constScanLine(j);
+        unsigned char *to = image.scanLine(y + j) + x;
+
+        for(int i = 0; i < strip.width(); ++i) {
+
+            to[i] = qGray(from[i]) > 127 ? EXPORT_FOREGROUND : EXPORT_BACKGROUND;
+        }
+    }
+}
+
+/* One pixel per column and per bin, one byte per pixel, so hours of history
+ * still fit in memory. Colors span the 1st to 99.9th percentile of the
+ * exported bins, read from a histogram of their quantized values. */
+bool Exporter::writePng() {
+
+    unsigned int columns = snapshot.columns;
+    unsigned int rows = end - start;
+
+    QVector<const unsigned char*> data(columns);
+    quint64 histogram[256] = {0};
+
+    for(unsigned int i = 0; i < columns; ++i) {
+
+        data[i] = snapshot.column(i) + start;
+
+        for(unsigned int j = 0; j < rows; ++j) {
+
+            histogram[data[i][j]]++;
+        }
+    }
+
+    quint64 total = (quint64) columns * rows;
+    quint64 lowRank = total / 100;
+    quint64 highRank = (total - 1) * 999 / 1000;
+    quint64 seen = 0;
+    int low = -1, high = -1;
+
+    for(int q = 0; q < 256 && high < 0; ++q) {
+
+        seen += histogram[q];
+        if(low < 0 && seen > lowRank) low = q;
+        if(seen > highRank) high = q;
+    }
+
+    double scale = high > low ? (EXPORT_LEVELS - 1.0) / (high - low) : 0;
+    unsigned char levels[256];
+
+    for(int q = 0; q < 256; ++q) {
+
+        double value = (q - low) * scale;
+        value = value > 0 ? value : 0;
+        value = value < EXPORT_LEVELS - 1 ? value : EXPORT_LEVELS - 1;
+        levels[q] = (unsigned char) value;
+    }
+
+    Palette palette;
+    QVector<QRgb> colors(256);
+
+    for(int i = 0; i < EXPORT_LEVELS; ++i) {
+
+        colors[i] = palette[i * 255 / (EXPORT_LEVELS - 1)].rgb();
+    }
+
+    colors[EXPORT_BACKGROUND] = qRgb(50, 50, 50);
+    colors[EXPORT_FOREGROUND] = qRgb(255, 255, 255);
+
+    QImage image(EXPORT_MARGIN_LEFT + columns, rows + EXPORT_MARGIN_BOTTOM, QImage::Format_Indexed8);
+
+    if(image.isNull()) {
+
+        return false;
+    }
+
+    image.setColorTable(colors);
+
+    for(unsigned int j = 0; j < rows; ++j) {
+
+        unsigned char *line = image.scanLine(rows - 1 - j) + EXPORT_MARGIN_LEFT;
+
+        for(unsigned int i = 0; i < columns; ++i) {
+
+            line[i] = levels[data[i][j]];
+        }
+    }
+
+    QImage left(EXPORT_MARGIN_LEFT, rows, QImage::Format_RGB32);
+    QImage bottom(image.width(), EXPORT_MARGIN_BOTTOM, QImage::Format_RGB32);
+    left.fill(QColor(0, 0, 0));
+    bottom.fill(QColor(0, 0, 0));
+
+    QPainter p;
+    p.begin(&left);
+    p.setPen(QColor(255, 255, 255));
+    QFont f = p.font();
+    f.setPixelSize(12);
+    f.setStyleStrategy(QFont::NoAntialias);
+    p.setFont(f);
+
+    /* frequency axis */
+    for(unsigned int j = 0; j < rows; j += EXPORT_TICK_SPACING) {
+
+        int y = rows - 1 - j;
+        p.drawLine(EXPORT_MARGIN_LEFT - 5, y, EXPORT_MARGIN_LEFT, y);
+        p.drawText(0, y - 10, EXPORT_MARGIN_LEFT - 8, 20, Qt::AlignRight | Qt::AlignVCenter, QString::number((start + j) * snapshot.df, 'f', 1));
+    }
+
+    p.end();
+    p.begin(&bottom);
+    p.setPen(QColor(255, 255, 255));
+    p.setFont(f);
+
+    /* time axis, UTC */
+    for(unsigned int i = 0; i < columns; i += EXPORT_TICK_SPACING) {
+
+        int x = EXPORT_MARGIN_LEFT + i;
+        QString time = QDateTime::fromMSecsSinceEpoch(snapshot.time(i)).toUTC().toString("HH:mm:ss");
+        p.drawLine(x, 0, x, 5);
+        p.drawText(x - 40, 8, 80, 20, Qt::AlignCenter, time);
+    }
+
+    p.drawText(0, 8, EXPORT_MARGIN_LEFT - 8, 20, Qt::AlignRight | Qt::AlignVCenter, "Hz / UTC");
+    p.end();
+
+    pasteMargin(left, image, 0, 0);
+    pasteMargin(bottom, image, 0, rows);
+
+    return image.save(path, "PNG");
+}
+
+/* NumPy format 1.0: magic, header length, a dict padded to 64 bytes, raw data.
+ * The magnitudes are restored from the history's HISTORY_DB_PER_STEP dB steps. */
+bool Exporter::writeNpy() {
+
+    unsigned int columns = snapshot.columns;
+    unsigned int rows = end - start;
+
+    QByteArray header = QString("{'descr': '<f4', 'fortran_order': False, 'shape': (%1, %2), }").arg(columns).arg(rows).toLatin1();
+    int total = 10 + header.size() + 1;
+    header.append(QByteArray((64 - total % 64) % 64, ' '));
+    header.append('\n');
+
+    QFile file(path);
+
+    if(!file.open(QIODevice::WriteOnly)) {
+
+        return false;
+    }
+
+    quint16 length = header.size();
+    char lengthBytes[2] = { (char) (length & 0xFF), (char) (length >> 8) };
+
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.write(lengthBytes, 2);
+    file.write(header);
+
+    float magnitudes[256];
+
+    for(int q = 0; q < 256; ++q) {
+
+        magnitudes[q] = pow(10, q * HISTORY_DB_PER_STEP / 20);
+    }
+
+    QVector<float> row(rows);
+
+    for(unsigned int i = 0; i < columns; ++i) {
+
+        const unsigned char *column = snapshot.column(i) + start;
+
+        for(unsigned int j = 0; j < rows; ++j) {
+
+            row[j] = magnitudes[column[j]];
+        }
+
+        if(file.write((const char *) row.constData(), rows * sizeof(float)) != (qint64) (rows * sizeof(float))) {
+
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <cmath>
+
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QImage>
+#include <QPainter>
+#include <QFile>
+#include <QDateTime>
+
+#include "history.h"
+#include "palette.h"
+
+#define EXPORT_MARGIN_LEFT 60
+#define EXPORT_MARGIN_BOTTOM 40
+#define EXPORT_TICK_SPACING 120
+#define EXPORT_LEVELS 254           // palette levels for the data
+#define EXPORT_BACKGROUND 254       // color index of the margins
+#define EXPORT_FOREGROUND 255       // color index of the axes
+
+/* Writes a history snapshot to disk on a thread pool, as an 8-bit indexed PNG
+ * with frequency and time axes or as a float32 .npy array of shape (columns,
+ * bins). Nothing is copied beyond one row of the output at a time. */
+class Exporter : public QObject, public QRunnable {
+
+    Q_OBJECT
+
+signals:
+
+    void finished(QString, bool);
+
+public:
+
+    Exporter(const HistorySnapshot&, QString, double, double);
+
+    void run();
+
+private:
+
+    bool writePng();
+    bool writeNpy();
+
+    HistorySnapshot snapshot;
+    QString path;
+    unsigned int start, end;
+};
+
+#endif // EXPORTER_H
@@ -0,0 +1,25 @@
+#ifndef FASTLOG_H
+#define FASTLOG_H
+
+#include <cstring>
+
+#include <QtGlobal>
+
+/* Approximate log2, accurate to about 1e-4 over the normal float range, that
+ * is well under a thousandth of a dB. Inlined into the per bin loops of the
+ * spectrogram and of the quantizers so they stay free of libm calls. */
+static inline float fastLog2(float x) {
+
+    quint32 bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    quint32 mantissaBits = (bits & 0x007FFFFF) | 0x3F000000;
+    float mantissa;
+    memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+
+    float y = bits * 1.1920928955078125e-7f;
+
+    return y - 124.22551499f - 1.498030302f * mantissa - 1.72587999f / (0.3520887068f + mantissa);
+}
+
+#endif // FASTLOG_H
@@ -1,15 +1,30 @@
 #include "fft.h"
 
-FFT::FFT(int fftSize, double sampleRate) : fftSize(fftSize), sampleRate(sampleRate) {
+/* With taps == 1 each frame is Hamming windowed before the FFT. With more taps
+ * the FFT is preceded by a polyphase filter bank: frames of taps * fftSize
+ * samples are weighted by a windowed-sinc prototype and folded into fftSize
+ * points, which keeps strong lines from leaking into neighbouring bins. */
+FFT::FFT(int fftSize, double sampleRate, int taps) : fftSize(fftSize), taps(taps > 1 ? taps : 1), sampleRate(sampleRate), integration(1), accumulated(0), integrationMode(Average) {
     
     nfreq = (fftSize / 2) + 1;
 
     result = new double [nfreq];
+    power = new double [nfreq];
 
     /* allocating space for the input and for the window */
-    input = (double *) fftw_malloc(2 * (size_t) fftSize * sizeof(double));
+    input = (double *) fftw_malloc((size_t) fftSize * sizeof(double));
     output = (fftw_complex *) fftw_malloc((size_t) nfreq * sizeof(fftw_complex));
-    window = compute_hamming(input + fftSize, fftSize);
+    window = new double [this->taps * fftSize];
+
+    if (this->taps == 1) {
+
+        compute_hamming(window, fftSize);
+    }
+
+    else {
+
+        compute_prototype(window, fftSize, this->taps);
+    }
 
     plan = fftw_plan_dft_r2c_1d(fftSize, input, output, FFTW_ESTIMATE);
 }
@@ -17,6 +32,8 @@ FFT::FFT(int fftSize, double sampleRate) : fftSize(fftSize), sampleRate(sampleRa
 FFT::~FFT()
 {
     delete[] result;
+    delete[] power;
+    delete[] window;
     fftw_destroy_plan(plan);
     fftw_free(output);
     fftw_free(input);
@@ -47,20 +64,127 @@ double* FFT::compute_hamming(double* data, int n) {
     return data;
 }
 
-void FFT::compute(double *data) {
+/* Returns the polyphase filter bank prototype of taps * n points: a sinc
+ * slightly wider than one bin, Hamming windowed over its whole length.
+ * h(i) = sinc(a (i - (L-1)/2) / n) * w(i), for i = 0..L-1, L = taps * n.
+ * With a = 1 adjacent channels cross at -6 dB, and a tone halfway between two
+ * bins loses 4 dB more than with the Hamming FFT. a = 1 + PFB_WIDENING / taps
+ * moves the crossing to -3 dB from 3 taps up (-2.7 dB at 2), and leakage
+ * 3 bins away stays 10 to 25 dB below the Hamming FFT's. */
+double* FFT::compute_prototype(double* data, int n, int taps) {
+
+    int l = taps * n;
+
+    compute_hamming(data, l);
+
+    for (int i = 0; i < l; ++i) {
+
+        double x = (1 + PFB_WIDENING / taps) * (i - (l - 1) / 2.0) / n;
+        data[i] *= x == 0 ? 1 : sin(M_PI * x) / (M_PI * x);
+    }
+
+    return data;
+}
 
+/* Weights a frame of inputSize() samples by the window and sums the taps
+ * branches into the fftSize points of `in`. */
+void FFT::fold(const double *data, double *in) const {
 
     for (unsigned int i = 0; i < fftSize; ++i) {
 
-        input[i] = window[i] * data[i];
+        in[i] = window[i] * data[i];
     }
 
+    for (unsigned int p = 1; p < taps; ++p) {
+
+        const double *w = window + p * fftSize;
+        const double *x = data + p * fftSize;
+
+        for (unsigned int i = 0; i < fftSize; ++i) {
+
+            in[i] += w[i] * x[i];
+        }
+    }
+}
+
+/* Number of samples expected by compute and magnitudes. */
+unsigned int FFT::inputSize() const {
+
+    return taps * fftSize;
+}
+
+/* Reentrant variant of compute for worker threads: folds `data` into the
+ * caller's fftw_malloc'ed scratch buffers and writes the nfreq - 1 magnitudes
+ * (DC excluded, as emitted by done) to `magnitudes`. */
+void FFT::magnitudes(const double *data, double *magnitudes, double *in, fftw_complex *out) const {
+
+    fold(data, in);
+
+    fftw_execute_dft_r2c(plan, in, out);
+
+    for (unsigned int i = 1; i < nfreq; ++i) {
+
+        magnitudes[i - 1] = sqrt(out[i][0] * out[i][0] + out[i][1] * out[i][1]);
+    }
+}
+
+void FFT::compute(double *data) {
+
+    fold(data, input);
+
     fftw_execute(plan);
 
+    /* accumulating power spectra, one column is emitted every `integration` frames */
+    if (accumulated == 0) {
+
+        for (unsigned int i = 1; i < nfreq; ++i) {
+
+            power[i] = output[i][0] * output[i][0] + output[i][1] * output[i][1];
+        }
+    }
+
+    else if (integrationMode == MaxHold) {
+
+        for (unsigned int i = 1; i < nfreq; ++i) {
+
+            double p = output[i][0] * output[i][0] + output[i][1] * output[i][1];
+            power[i] = p > power[i] ? p : power[i];
+        }
+    }
+
+    else {
+
+        for (unsigned int i = 1; i < nfreq; ++i) {
+
+            power[i] += output[i][0] * output[i][0] + output[i][1] * output[i][1];
+        }
+    }
+
+    if (++accumulated < integration) {
+
+        return;
+    }
+
+    double norm = integrationMode == Average ? 1.0 / accumulated : 1.0;
+
     for (unsigned int i = 1; i < nfreq; ++i) {
 
-        result[i] = sqrt(output[i][0] * output[i][0] + output[i][1] * output[i][1]);
+        result[i] = sqrt(power[i] * norm);
     }
 
+    accumulated = 0;
     emit done(result + 1);
 }
+
+/* Number of spectra combined into each emitted column. */
+void FFT::setIntegration(int count) {
+
+    integration = count > 1 ? count : 1;
+    accumulated = 0;
+}
+
+void FFT::setIntegrationMode(int mode) {
+
+    integrationMode = mode == MaxHold ? MaxHold : Average;
+    accumulated = 0;
+}
@@ -6,6 +6,8 @@
 #include <QObject>
 #include <iostream>
 
+#define PFB_WIDENING 0.8    // the prototype's sinc is 1 + PFB_WIDENING / taps bins wide
+
 class FFT : public QObject
 {
 
@@ -14,6 +16,8 @@ class FFT : public QObject
 public slots:
 
     void compute(double*);
+    void setIntegration(int);
+    void setIntegrationMode(int);
 
 signals:
 
@@ -21,17 +25,27 @@ signals:
 
 public:
 
-    FFT(int, double);
+    enum IntegrationMode { Average, MaxHold };
+
+    FFT(int, double, int taps = 1);
     ~FFT();
 
+    unsigned int inputSize() const;
+    void magnitudes(const double*, double*, double*, fftw_complex*) const;
+
 private:
 
     double* compute_hamming(double*, int);
+    double* compute_prototype(double*, int, int);
+    void fold(const double*, double*) const;
 
-    unsigned int fftSize, nfreq;
+    unsigned int fftSize, nfreq, taps;
     double sampleRate;
 
-    double *input, *window, *result;
+    unsigned int integration, accumulated;
+    IntegrationMode integrationMode;
+
+    double *input, *window, *result, *power;
 
     fftw_complex *output;
     fftw_plan plan;
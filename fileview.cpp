@@ -0,0 +1,397 @@
+#include "fileview.h"
+
+TileJob::TileJob(FileView *view, int tile, QByteArray spectra, QVector<int> rowFrom, QVector<int> rowTo, int generation) : view(view), tile(tile), generation(generation), spectra(spectra), rowFrom(rowFrom), rowTo(rowTo) {}
+
+/* The reduced tile holds TILE_COLUMNS columns of one byte per row, then one
+ * more column with their maximum. */
+void TileJob::run() {
+
+    if(spectra.isEmpty()) {
+
+        compute();
+    }
+
+    int bins = view->bins;
+    int h = rowFrom.size();
+
+    QByteArray reduced((TILE_COLUMNS + 1) * h, 0);
+    uchar *summary = (uchar *) reduced.data() + TILE_COLUMNS * h;
+
+    for(int c = 0; c < TILE_COLUMNS; ++c) {
+
+        const uchar *column = (const uchar *) spectra.constData() + c * bins;
+        uchar *rows = (uchar *) reduced.data() + c * h;
+
+        for(int y = 0; y < h; ++y) {
+
+            uchar m = 0;
+
+            for(int j = rowFrom[y]; j < rowTo[y]; ++j) {
+
+                m = column[j] > m ? column[j] : m;
+            }
+
+            rows[y] = m;
+            summary[y] = m > summary[y] ? m : summary[y];
+        }
+    }
+
+    QMetaObject::invokeMethod(view, "tileReady", Qt::QueuedConnection, Q_ARG(int, tile), Q_ARG(int, generation), Q_ARG(QByteArray, spectra), Q_ARG(QByteArray, reduced));
+}
+
+/* The frames of a tile overlap by all but one hop, so its whole span is read,
+ * and decimated, once and the frames are taken from it. */
+void TileJob::compute() {
+
+    int fftSize = view->fftSize;
+    int bins = view->bins;
+    int hop = view->hop;
+
+    qint64 first = (qint64) tile * TILE_COLUMNS;
+    int count = view->columns - first < TILE_COLUMNS ? view->columns - first : TILE_COLUMNS;
+
+    int size = view->fft->inputSize();
+    int span = (count - 1) * hop + size;
+    int factor = view->decimator->factor();
+    int rawSize = factor > 1 ? (span - 1) * factor + view->decimator->length() : 0;
+
+    double *data = new double[span];
+    float *raw = new float[rawSize];
+    double *magnitudes = new double[bins];
+    double *in = (double *) fftw_malloc((size_t) fftSize * sizeof(double));
+    fftw_complex *out = (fftw_complex *) fftw_malloc((size_t) (bins + 1) * sizeof(fftw_complex));
+
+    if(factor > 1) {
+
+        view->file.read(first * hop * factor, rawSize, raw);
+        view->decimator->decimate(raw, span, data);
+    }
+
+    else {
+
+        view->file.read(first * hop, span, data);
+    }
+
+    spectra = QByteArray(TILE_COLUMNS * bins, 0);
+    float scale = (float) (20 * log10(2.0) / TILE_DB_PER_STEP);
+
+    for(int c = 0; c < count; ++c) {
+
+        view->fft->magnitudes(data + (size_t) c * hop, magnitudes, in, out);
+
+        uchar *q = (uchar *) spectra.data() + c * bins;
+
+        for(int i = 0; i < bins; ++i) {
+
+            float value = fastLog2(magnitudes[i] + 1e-6) * scale;
+            value = value > 0 ? value : 0;
+            value = value < 255 ? value : 255;
+            q[i] = (uchar) value;
+        }
+    }
+
+    fftw_free(out);
+    fftw_free(in);
+    delete[] magnitudes;
+    delete[] data;
+    delete[] raw;
+}
+
+FileView::FileView(QString path, int fftSize, double targetRate, double freqFrom, double freqTo, QWidget *parent) : QWidget(parent), path(path), fftSize(fftSize), freqFrom(freqFrom), freqTo(freqTo), firstColumn(0), columnsPerPixel(1), lastX(0), generation(0) {
+
+    valid = file.open(path);
+
+    decimator = new Decimator(valid ? file.sampleRate() : targetRate, targetRate);
+
+    double sampleRate = decimator->outputRate();
+    int factor = decimator->factor();
+    qint64 length = factor > 1 ? (file.length() >= decimator->length() ? (file.length() - decimator->length()) / factor + 1 : 0) : file.length();
+
+    fft = new FFT(fftSize, sampleRate);
+    bins = fftSize / 2;
+    hop = round((double) fftSize / 10);
+    df = sampleRate / fftSize;
+    columns = length >= (qint64) fft->inputSize() ? (length - fft->inputSize()) / hop + 1 : 0;
+
+    double passband = Decimator::passband(valid ? file.sampleRate() : targetRate, sampleRate);
+    if(this->freqTo > passband) this->freqTo = passband;
+    if(this->freqFrom >= this->freqTo) this->freqFrom = 0;
+
+    /* cache cost is in kilobytes */
+    tiles.setMaxCost(TILE_CACHE_MB * 1024);
+    reduced.setMaxCost(TILE_VIEW_CACHE_MB * 1024);
+
+    Palette palette;
+
+    for(int i = 0; i < 256; ++i) {
+
+        colors[i] = palette[i].rgb();
+    }
+
+    setMinimumSize(750, 300);
+    updateTitle();
+
+    std::cout << path.toStdString() << ": " << file.length() << " samples at " << file.sampleRate() << " Hz, analysed at " << sampleRate << " Hz, " << columns << " columns" << std::endl;
+}
+
+FileView::~FileView() {
+
+    pool.clear();
+    pool.waitForDone();
+    delete fft;
+    delete decimator;
+}
+
+bool FileView::isValid() const {
+
+    return valid && columns > 0;
+}
+
+/* A reduction made for an older height is dropped, the next paint asks again. */
+void FileView::tileReady(int tile, int generation, QByteArray spectra, QByteArray rows) {
+
+    pending.remove(tile);
+
+    if(!tiles.contains(tile)) {
+
+        tiles.insert(tile, new QByteArray(spectra), spectra.size() / 1024);
+    }
+
+    if(generation == this->generation) {
+
+        reduced.insert(tile, new QByteArray(rows), rows.size() / 1024 + 1);
+    }
+
+    update();
+}
+
+/* Returns the reduced tile if it is cached. Otherwise schedules it, from the
+ * cached spectra when there are some. */
+const uchar* FileView::requestTile(int tile) {
+
+    QByteArray *rows = reduced.object(tile);
+
+    if(rows) {
+
+        return (const uchar *) rows->constData();
+    }
+
+    if(!pending.contains(tile)) {
+
+        QByteArray *spectra = tiles.object(tile);
+
+        pending.insert(tile);
+        pool.start(new TileJob(this, tile, spectra ? *spectra : QByteArray(), rowFrom, rowTo, generation));
+    }
+
+    return 0;
+}
+
+QString FileView::timeAt(double column) const {
+
+    double seconds = column * hop / decimator->outputRate();
+
+    if(file.startTime() == 0) {
+
+        return QString::number(seconds, 'f', 1) + " s";
+    }
+
+    qint64 msecs = file.startTime() / 1000 + (qint64) (seconds * 1000);
+    return QDateTime::fromMSecsSinceEpoch(msecs).toUTC().toString("HH:mm:ss");
+}
+
+void FileView::updateTitle() {
+
+    QString title = path;
+
+    if(isValid()) {
+
+        title += " [" + timeAt(firstColumn) + " - " + timeAt(firstColumn + width() * columnsPerPixel) + "]";
+    }
+
+    setWindowTitle(title);
+}
+
+void FileView::clampView() {
+
+    double last = columns - width() * columnsPerPixel;
+
+    if(firstColumn > last) firstColumn = last;
+    if(firstColumn < 0) firstColumn = 0;
+
+    updateTitle();
+}
+
+/* Maps the rows of the view to the bins they cover. The reduced tiles depend
+ * on it, so they are dropped and in-flight reductions ignored. */
+void FileView::resizeEvent(QResizeEvent*) {
+
+    int h = height();
+    double rowsPerPixel = ((freqTo - freqFrom) / df) / h;
+
+    rowFrom.resize(h);
+    rowTo.resize(h);
+
+    for(int y = 0; y < h; ++y) {
+
+        int k = h - 1 - y;
+        rowFrom[y] = freqFrom / df + k * rowsPerPixel;
+        rowTo[y] = freqFrom / df + (k + 1) * rowsPerPixel;
+        if(rowTo[y] <= rowFrom[y]) rowTo[y] = rowFrom[y] + 1;
+        if(rowTo[y] > bins) rowTo[y] = bins;
+    }
+
+    reduced.clear();
+    generation++;
+    clampView();
+}
+
+/* Every pixel is the maximum over all the columns and bins it covers, so short
+ * echoes stay visible when zoomed out. Whole tiles under a pixel count through
+ * their maximum column. Colors span the 20th to 99.9th percentile of the
+ * visible values, read off a histogram of the quantized bytes. */
+void FileView::paintEvent(QPaintEvent*) {
+
+    QPainter p(this);
+    int w = width();
+    int h = height();
+
+    if(!isValid()) {
+
+        p.fillRect(rect(), QColor(50, 50, 50));
+        p.setPen(QColor(255, 255, 255));
+        p.drawText(rect(), Qt::AlignCenter, "Cannot read " + path);
+        return;
+    }
+
+    /* one run of h values per pixel column */
+    QVector<int> values(w * h, -1);
+    QVector<int> histogram(256, 0);
+    int total = 0;
+
+    for(int x = 0; x < w; ++x) {
+
+        qint64 c0 = firstColumn + x * columnsPerPixel;
+        qint64 c1 = firstColumn + (x + 1) * columnsPerPixel;
+        if(c1 <= c0) c1 = c0 + 1;
+        if(c1 > columns) c1 = columns;
+
+        int *v = values.data() + x * h;
+
+        for(qint64 c = c0; c < c1; ) {
+
+            int t = c / TILE_COLUMNS;
+            qint64 next = (qint64) (t + 1) * TILE_COLUMNS;
+            if(next > c1) next = c1;
+
+            const uchar *tile = requestTile(t);
+
+            if(tile) {
+
+                const uchar *from = tile + (c % TILE_COLUMNS) * h;
+                int count = next - c;
+
+                if(count == TILE_COLUMNS) {
+
+                    from = tile + TILE_COLUMNS * h;
+                    count = 1;
+                }
+
+                for(int k = 0; k < count; ++k, from += h) {
+
+                    for(int y = 0; y < h; ++y) {
+
+                        v[y] = from[y] > v[y] ? from[y] : v[y];
+                    }
+                }
+            }
+
+            c = next;
+        }
+
+        if(v[0] >= 0) {
+
+            for(int y = 0; y < h; ++y) {
+
+                histogram[v[y]]++;
+            }
+
+            total += h;
+        }
+    }
+
+    int low = 0, high = 255;
+
+    for(int i = 0, n = 0; i < 256; ++i) {
+
+        n += histogram[i];
+        if(n <= total / 5) low = i;
+        if(n < total - total / 1000) high = i + 1;
+    }
+
+    double scale = high > low ? 255.0 / (high - low) : 0;
+
+    QImage image(w, h, QImage::Format_RGB32);
+
+    for(int y = 0; y < h; ++y) {
+
+        QRgb *line = (QRgb *) image.scanLine(y);
+
+        for(int x = 0; x < w; ++x) {
+
+            int v = values[x * h + y];
+
+            if(v < 0) {
+
+                line[x] = qRgb(50, 50, 50);
+                continue;
+            }
+
+            int i = (v - low) * scale;
+            line[x] = colors[i < 0 ? 0 : (i > 255 ? 255 : i)];
+        }
+    }
+
+    p.drawImage(0, 0, image);
+
+    /* time axis */
+    p.setPen(QColor(255, 255, 255));
+    QFont f = p.font();
+    f.setPixelSize(12);
+    p.setFont(f);
+
+    for(int x = 0; x < w; x += 150) {
+
+        p.drawLine(x, h - 5, x, h);
+        p.drawText(x + 3, h - 20, 100, 15, Qt::AlignLeft, timeAt(firstColumn + x * columnsPerPixel));
+    }
+}
+
+void FileView::mousePressEvent(QMouseEvent *event) {
+
+    lastX = event->x();
+}
+
+void FileView::mouseMoveEvent(QMouseEvent *event) {
+
+    firstColumn -= (event->x() - lastX) * columnsPerPixel;
+    lastX = event->x();
+    clampView();
+    update();
+}
+
+/* Zooms in time around the column under the cursor. */
+void FileView::wheelEvent(QWheelEvent *event) {
+
+    double anchor = firstColumn + event->pos().x() * columnsPerPixel;
+    double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    double widest = (double) columns / width();
+
+    columnsPerPixel *= factor;
+    if(columnsPerPixel > widest) columnsPerPixel = widest;
+    if(columnsPerPixel < 0.125) columnsPerPixel = 0.125;
+
+    firstColumn = anchor - event->pos().x() * columnsPerPixel;
+    clampView();
+    update();
+}
@@ -0,0 +1,110 @@
+#ifndef FILEVIEW_H
+#define FILEVIEW_H
+
+#include <cmath>
+#include <iostream>
+
+#include <QWidget>
+#include <QImage>
+#include <QPainter>
+#include <QCache>
+#include <QSet>
+#include <QByteArray>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QResizeEvent>
+#include <QDateTime>
+
+#include "bramsfile.h"
+#include "fft.h"
+#include "decimator.h"
+#include "palette.h"
+#include "fastlog.h"
+
+#define TILE_COLUMNS 64
+#define TILE_DB_PER_STEP 0.75  // 0 to 191 dB, as HISTORY_DB_PER_STEP and COLUMN_DB_PER_STEP
+#define TILE_CACHE_MB 256
+#define TILE_VIEW_CACHE_MB 32
+
+class FileView;
+
+/* Computes the quantized columns of one tile on the thread pool, unless they
+ * are given, and reduces them to the rows of the view. */
+class TileJob : public QRunnable {
+
+public:
+
+    TileJob(FileView*, int, QByteArray, QVector<int>, QVector<int>, int);
+    void run();
+
+private:
+
+    void compute();
+
+    FileView *view;
+    int tile, generation;
+    QByteArray spectra;
+    QVector<int> rowFrom, rowTo;
+};
+
+/* Browses a recording without streaming it: the file is split into tiles of
+ * TILE_COLUMNS columns, only the tiles under the viewport are computed, on all
+ * cores, and they are kept quantized (one byte per bin) in an LRU cache. A
+ * second LRU cache keeps each tile reduced to the rows on screen, plus the
+ * maximum over its columns, so panning and repainting never go back to the
+ * bins. It is dropped when the height changes.
+ * Recordings faster than the analysis rate are decimated once per tile.
+ * Drag to pan, wheel to zoom in time. */
+class FileView : public QWidget {
+
+    Q_OBJECT
+
+    friend class TileJob;
+
+public:
+
+    FileView(QString, int, double, double, double, QWidget *parent = 0);
+    ~FileView();
+
+    bool isValid() const;
+
+private slots:
+
+    void tileReady(int, int, QByteArray, QByteArray);
+
+private:
+
+    void paintEvent(QPaintEvent*);
+    void mousePressEvent(QMouseEvent*);
+    void mouseMoveEvent(QMouseEvent*);
+    void wheelEvent(QWheelEvent*);
+    void resizeEvent(QResizeEvent*);
+
+    void clampView();
+    void updateTitle();
+    QString timeAt(double) const;
+    const uchar* requestTile(int);
+
+    QString path;
+    BramsFile file;
+    FFT *fft;
+    Decimator *decimator;
+    QRgb colors[256];
+
+    QCache<int, QByteArray> tiles, reduced;
+    QVector<int> rowFrom, rowTo;
+    QSet<int> pending;
+    QThreadPool pool;
+
+    int fftSize, bins, hop;
+    qint64 columns;
+    double df, freqFrom, freqTo;
+
+    double firstColumn, columnsPerPixel;
+    int lastX, generation;
+    bool valid;
+};
+
+#endif // FILEVIEW_H
@@ -0,0 +1,76 @@
+#include "history.h"
+
+const unsigned char *HistorySnapshot::column(unsigned int i) const {
+
+    unsigned int j = (first + i) % capacity;
+    return (const unsigned char *) blocks[j / HISTORY_BLOCK].constData() + (size_t) (j % HISTORY_BLOCK) * bins;
+}
+
+qint64 HistorySnapshot::time(unsigned int i) const {
+
+    return times[(first + i) % capacity];
+}
+
+History::History(int fftSize, double sampleRate, unsigned int capacity) : bins(fftSize / 2), capacity(capacity), count(0), next(0) {
+
+    df = sampleRate / fftSize;
+
+    blocks.resize((capacity + HISTORY_BLOCK - 1) / HISTORY_BLOCK);
+    times.resize(capacity);
+}
+
+void History::append(double *frame) {
+
+    QByteArray &block = blocks[next / HISTORY_BLOCK];
+
+    if(block.isEmpty()) {
+
+        block.resize(HISTORY_BLOCK * bins);
+    }
+
+    /* detaches the block if a snapshot still holds it */
+    unsigned char *column = (unsigned char *) block.data() + (size_t) (next % HISTORY_BLOCK) * bins;
+
+    float scale = (float) (20 * log10(2.0) / HISTORY_DB_PER_STEP);
+
+    for(unsigned int i = 0; i < bins; ++i) {
+
+        float value = frame[i] > 0 ? fastLog2(frame[i]) * scale : 0;
+
+        if(value < 0) value = 0;
+        if(value > 255) value = 255;
+
+        column[i] = (unsigned char) value;
+    }
+
+    times[next] = QDateTime::currentMSecsSinceEpoch();
+    next = (next + 1) % capacity;
+    if(count < capacity) count++;
+}
+
+/* Columns at another bin width cannot be exported together, so the history restarts. */
+void History::setSampleRate(double sampleRate) {
+
+    df = sampleRate / (2 * bins);
+    count = 0;
+    next = 0;
+}
+
+HistorySnapshot History::snapshot() const {
+
+    HistorySnapshot snapshot;
+    snapshot.blocks = blocks;
+    snapshot.times = times;
+    snapshot.first = (next + capacity - count) % capacity;
+    snapshot.columns = count;
+    snapshot.capacity = capacity;
+    snapshot.bins = bins;
+    snapshot.df = df;
+
+    return snapshot;
+}
+
+unsigned int History::size() const {
+
+    return count;
+}
@@ -0,0 +1,58 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cmath>
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+#include <QDateTime>
+
+#include "fastlog.h"
+
+#define HISTORY_BLOCK 256           // columns per block
+#define HISTORY_DB_PER_STEP 0.75    // quantization of the stored magnitudes, as ColumnServer
+
+/* Chronological view of the history, safe to hand over to another thread.
+ * The blocks are shared with History until it writes to them again, so taking
+ * a snapshot costs nothing but reference counts. */
+struct HistorySnapshot {
+
+    const unsigned char *column(unsigned int) const;
+    qint64 time(unsigned int) const;
+
+    QVector<QByteArray> blocks;     // ring of HISTORY_BLOCK columns of quantized magnitudes
+    QVector<qint64> times;          // milliseconds since epoch (UTC) of each ring slot
+    unsigned int first, columns, capacity, bins;
+    double df;
+};
+
+/* Ring buffer of the last full resolution columns, fed by FFT::done. Every
+ * bin is kept as 20 * log10(magnitude) in steps of HISTORY_DB_PER_STEP dB, one
+ * byte per bin, and blocks are only allocated once they are reached. */
+class History : public QObject {
+
+    Q_OBJECT
+
+public slots:
+
+    void append(double*);
+    void setSampleRate(double);
+
+public:
+
+    History(int, double, unsigned int);
+
+    HistorySnapshot snapshot() const;
+    unsigned int size() const;
+
+private:
+
+    unsigned int bins, capacity, count, next;
+    double df;
+
+    QVector<QByteArray> blocks;
+    QVector<qint64> times;
+};
+
+#endif // HISTORY_H
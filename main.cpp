@@ -1,8 +1,291 @@
 #include "mainwindow.h"
+#include "columnserver.h"
+#include "history.h"
+#include "exporter.h"
+#include "fileview.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <cstring>
+#include <string>
+
+/* Headless mode: connects once to the station, runs the FFT and the column
+ * reduction, and serves the columns to any number of viewers. */
+int serve(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("serve", "Serve columns to viewers on <port>.", "port"));
+    parser.addOption(QCommandLineOption("host", "Station host.", "host", "127.0.0.1"));
+    parser.addOption(QCommandLineOption("port", "Station port.", "port", "4321"));
+    parser.addOption(QCommandLineOption("bins", "Bins per column.", "bins", "1024"));
+    parser.addOption(QCommandLineOption("from", "Lowest frequency in Hz.", "hz", QString::number(FREQFROM)));
+    parser.addOption(QCommandLineOption("to", "Highest frequency in Hz.", "hz", QString::number(FREQTO)));
+    parser.addOption(QCommandLineOption("history", "Columns sent to late joiners.", "columns", "864"));
+    parser.addOption(QCommandLineOption("integrate", "Spectra averaged into each column.", "count", "1"));
+    parser.addOption(QCommandLineOption("taps", "Polyphase filter bank taps per branch, 1 for a Hamming window.", "taps", "1"));
+    parser.addOption(QCommandLineOption("critical", "Critically sampled transforms (no overlap)."));
+    parser.addOption(QCommandLineOption("compressed", "The station sends Rice coded blocks (bramsriff.py --compress)."));
+    parser.process(a);
+
+    unsigned int bins = parser.value("bins").toUInt();
+    unsigned int history = parser.value("history").toUInt();
+
+    if(bins == 0 || bins > FFTSIZE / 2 || history == 0) {
+
+        std::cout << "invalid --bins or --history" << std::endl;
+        return 1;
+    }
+
+    FFT fft(FFTSIZE, SAMPLERATE, parser.value("taps").toInt());
+    TcpClient tcpClient(fft.inputSize(), parser.isSet("critical") ? FFTSIZE : FFTHOP, parser.value("host"), parser.value("port").toInt(), SAMPLERATE);
+    tcpClient.setCompressed(parser.isSet("compressed"));
+    ColumnServer server(parser.value("serve").toInt(), FFTSIZE, SAMPLERATE, bins, parser.value("from").toDouble(), parser.value("to").toDouble(), history);
+
+    if(!server.isListening()) {
+
+        return 1;
+    }
+
+    fft.setIntegration(parser.value("integrate").toInt());
+
+    QObject::connect(&tcpClient, SIGNAL(fftDataReady(double*)), &fft, SLOT(compute(double*)));
+    QObject::connect(&fft, SIGNAL(done(double*)), &server, SLOT(publish(double*)));
+    QObject::connect(&tcpClient, SIGNAL(sampleRateChanged(double, double)), &server, SLOT(setSampleRate(double, double)));
+
+    return a.exec();
+}
+
+/* Command line export: records the station for a while, then writes the
+ * history to a PNG or .npy file and exits. The PNG axes need fonts, hence a
+ * QGuiApplication (-platform offscreen works without a display). */
+int record(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("export", "Write the history to <file> (.png or .npy).", "file"));
+    parser.addOption(QCommandLineOption("duration", "Seconds to record before exporting.", "seconds", "600"));
+    parser.addOption(QCommandLineOption("host", "Station host.", "host", "127.0.0.1"));
+    parser.addOption(QCommandLineOption("port", "Station port.", "port", "4321"));
+    parser.addOption(QCommandLineOption("from", "Lowest frequency in Hz.", "hz", QString::number(FREQFROM)));
+    parser.addOption(QCommandLineOption("to", "Highest frequency in Hz.", "hz", QString::number(FREQTO)));
+    parser.addOption(QCommandLineOption("history", "Columns kept for the export.", "columns", QString::number(HISTORYLENGTH)));
+    parser.addOption(QCommandLineOption("integrate", "Spectra averaged into each column.", "count", "1"));
+    parser.addOption(QCommandLineOption("taps", "Polyphase filter bank taps per branch, 1 for a Hamming window.", "taps", "1"));
+    parser.addOption(QCommandLineOption("critical", "Critically sampled transforms (no overlap)."));
+    parser.addOption(QCommandLineOption("compressed", "The station sends Rice coded blocks (bramsriff.py --compress)."));
+    parser.process(a);
+
+    unsigned int length = parser.value("history").toUInt();
+
+    if(length == 0) {
+
+        std::cout << "invalid --history" << std::endl;
+        return 1;
+    }
+
+    FFT fft(FFTSIZE, SAMPLERATE, parser.value("taps").toInt());
+    TcpClient tcpClient(fft.inputSize(), parser.isSet("critical") ? FFTSIZE : FFTHOP, parser.value("host"), parser.value("port").toInt(), SAMPLERATE);
+    tcpClient.setCompressed(parser.isSet("compressed"));
+    History history(FFTSIZE, SAMPLERATE, length);
+
+    fft.setIntegration(parser.value("integrate").toInt());
+
+    QObject::connect(&tcpClient, SIGNAL(fftDataReady(double*)), &fft, SLOT(compute(double*)));
+    QObject::connect(&fft, SIGNAL(done(double*)), &history, SLOT(append(double*)));
+    QObject::connect(&tcpClient, SIGNAL(sampleRateChanged(double, double)), &history, SLOT(setSampleRate(double)));
+
+    QString path = parser.value("export");
+    double freqFrom = parser.value("from").toDouble();
+    double freqTo = parser.value("to").toDouble();
+
+    /* a decimated stream is only flat up to the decimator's passband */
+    QObject::connect(&tcpClient, &TcpClient::sampleRateChanged, [&freqTo](double analysisRate, double inputRate) {
+
+        freqTo = qMin(freqTo, Decimator::passband(inputRate, analysisRate));
+    });
+
+    QTimer::singleShot(parser.value("duration").toDouble() * 1000, [&]() {
+
+        QObject::disconnect(&fft, SIGNAL(done(double*)), &history, SLOT(append(double*)));
+
+        Exporter *exporter = new Exporter(history.snapshot(), path, freqFrom, freqTo);
+        QObject::connect(exporter, &Exporter::finished, &a, [&a, exporter](QString path, bool ok) {
+
+            std::cout << (ok ? "exported " : "export failed: ") << path.toStdString() << std::endl;
+            exporter->deleteLater();
+            a.exit(ok ? 0 : 1);
+        });
+        QThreadPool::globalInstance()->start(exporter);
+    });
+
+    return a.exec();
+}
+
+/* File viewer mode: browses a BRAMS recording instead of a live stream. */
+int view(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("file", "BRAMS WAV recording to browse.", "file"));
+    parser.addOption(QCommandLineOption("from", "Lowest frequency in Hz.", "hz", QString::number(FREQFROM)));
+    parser.addOption(QCommandLineOption("to", "Highest frequency in Hz.", "hz", QString::number(FREQTO)));
+    parser.process(a);
+
+    FileView w(parser.value("file"), FFTSIZE, SAMPLERATE, parser.value("from").toDouble(), parser.value("to").toDouble());
+    w.show();
+
+    return a.exec();
+}
+
+/* Decodes a Rice coded stream (bramsriff.py --compress) to raw int16 samples
+ * through RiceDecoder, in odd sized chunks so that blocks straddle reads as
+ * they do on the socket. Used by ricecheck.py to keep both sides in sync. */
+int decode(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("decode", "Rice coded input <file>.", "file"));
+    parser.addOption(QCommandLineOption("output", "Raw int16 output <file>.", "file"));
+    parser.process(a);
+
+    QFile input(parser.value("decode"));
+    QFile output(parser.value("output"));
+
+    if(!input.open(QIODevice::ReadOnly) || !output.open(QIODevice::WriteOnly)) {
+
+        std::cout << "cannot open --decode or --output" << std::endl;
+        return 1;
+    }
+
+    RiceDecoder decoder;
+    QByteArray samples;
+
+    while(!input.atEnd()) {
+
+        decoder.decode(input.read(4093), samples);
+        output.write(samples);
+        samples.clear();
+    }
+
+    return 0;
+}
+
+/* Compares the spectral engines on a tone halfway between two bins: time per
+ * column, its peak relative to that of a tone on a bin (scalloping loss), and
+ * worst leakage 3 and 10 bins away from the tone. */
+int benchmark()
+{
+    const int runs = 200;
+    const double tone = 1000.5;
+    const double onBin = 1000;
+    const int engines[] = { 1, 2, 4, 8 };
+
+    for(int e = 0; e < 4; ++e) {
+
+        FFT fft(FFTSIZE, SAMPLERATE, engines[e]);
+        unsigned int n = fft.inputSize();
+
+        double *data = new double[n];
+        double *magnitudes = new double[FFTSIZE / 2];
+        double *in = (double *) fftw_malloc(FFTSIZE * sizeof(double));
+        fftw_complex *out = (fftw_complex *) fftw_malloc((FFTSIZE / 2 + 1) * sizeof(fftw_complex));
+
+        for(unsigned int i = 0; i < n; ++i) {
+
+            data[i] = cos(2 * M_PI * tone * i / FFTSIZE);
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int r = 0; r < runs; ++r) {
+
+            fft.magnitudes(data, magnitudes, in, out);
+        }
+
+        double elapsed = timer.nsecsElapsed() / 1000.0 / runs;
+        double peak = 0, onBinPeak = 0, leak3 = 0, leak10 = 0;
+
+        /* magnitudes[i] is bin i + 1 */
+        for(int i = 0; i < FFTSIZE / 2; ++i) {
+
+            double distance = fabs(i + 1 - tone);
+
+            if(magnitudes[i] > peak) peak = magnitudes[i];
+            if(distance >= 3 && magnitudes[i] > leak3) leak3 = magnitudes[i];
+            if(distance >= 10 && magnitudes[i] > leak10) leak10 = magnitudes[i];
+        }
+
+        for(unsigned int i = 0; i < n; ++i) {
+
+            data[i] = cos(2 * M_PI * onBin * i / FFTSIZE);
+        }
+
+        fft.magnitudes(data, magnitudes, in, out);
+
+        for(int i = 0; i < FFTSIZE / 2; ++i) {
+
+            if(magnitudes[i] > onBinPeak) onBinPeak = magnitudes[i];
+        }
+
+        std::cout << (engines[e] == 1 ? std::string("hamming FFT   ") : "PFB, " + std::to_string(engines[e]) + " taps  ")
+                  << elapsed << " us/column, half-bin tone " << 20 * log10(peak / onBinPeak) << " dB, "
+                  << "leakage " << 20 * log10(leak3 / peak) << " dB at 3 bins, "
+                  << 20 * log10(leak10 / peak) << " dB at 10 bins" << std::endl;
+
+        fftw_free(out);
+        fftw_free(in);
+        delete[] magnitudes;
+        delete[] data;
+    }
+
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    for(int i = 1; i < argc; ++i) {
+
+        if(strncmp(argv[i], "--serve", 7) == 0) {
+
+            return serve(argc, argv);
+        }
+
+        if(strncmp(argv[i], "--export", 8) == 0) {
+
+            return record(argc, argv);
+        }
+
+        if(strncmp(argv[i], "--decode", 8) == 0) {
+
+            return decode(argc, argv);
+        }
+
+        if(strcmp(argv[i], "--benchmark") == 0) {
+
+            return benchmark();
+        }
+
+        if(strncmp(argv[i], "--file", 6) == 0) {
+
+            return view(argc, argv);
+        }
+    }
+
     QApplication a(argc, argv);
 
     MainWindow w;
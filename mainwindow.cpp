@@ -1,15 +1,29 @@
 #include "mainwindow.h"
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false) {
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), tcpClient(0), columnClient(0), toneTracker(0), toneStrip(0), initialized(false) {
 
     QDialog dialog(this);
     QFormLayout form(&dialog);
     host = new QLineEdit;
     port = new QLineEdit;
+    viewer = new QCheckBox;
+    taps = new QSpinBox;
+    taps->setMinimum(1);
+    taps->setMaximum(16);
+    critical = new QCheckBox;
+    compressed = new QCheckBox;
+    tones = new QLineEdit;
+    toneLog = new QLineEdit;
     dialog.setModal(true);
 
     form.addRow(QString("Host"), host);
     form.addRow(QString("Port"), port);
+    form.addRow(QString("Compute server"), viewer);
+    form.addRow(QString("Filter bank taps (1 = Hamming)"), taps);
+    form.addRow(QString("Critically sampled"), critical);
+    form.addRow(QString("Compressed stream"), compressed);
+    form.addRow(QString("Tracked tones (Hz)"), tones);
+    form.addRow(QString("Tone log"), toneLog);
 
     port->setValidator(new QIntValidator(0, 65536, &dialog));
     QDialogButtonBox buttonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, &dialog);
@@ -37,9 +51,20 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
     this->setWindowState(Qt::WindowMaximized);
     this->setMinimumSize(750, 300);
 
-    tcpClient = new TcpClient(FFTSIZE, host->text(), port->text().toInt());
+    fft = new FFT(FFTSIZE, SAMPLERATE, taps->value());
 
-    fft = new FFT(FFTSIZE, SAMPLERATE);
+    /* as a viewer of a compute server, columns arrive already transformed */
+    if(viewer->isChecked()) {
+
+        columnClient = new ColumnClient(FFTSIZE, SAMPLERATE, host->text(), port->text().toInt());
+    }
+
+    else {
+
+        tcpClient = new TcpClient(fft->inputSize(), critical->isChecked() ? FFTSIZE : FFTHOP, host->text(), port->text().toInt(), SAMPLERATE);
+        tcpClient->setCompressed(compressed->isChecked());
+    }
+    history = new History(FFTSIZE, SAMPLERATE, HISTORYLENGTH);
 
     /* Spectrogram Layout */
 
@@ -52,7 +77,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
     scaleLabelRight->setMaximumWidth(50);
 
     spectrogramLabel = new QLabel();
-    spectrogram = new Spectrogram(spectrogramLabel, FFTSIZE, SAMPLERATE);
+    /* a compute server does not announce its hop or integration, its defaults are assumed */
+    spectrogram = new Spectrogram(spectrogramLabel, FFTSIZE, critical->isChecked() && !viewer->isChecked() ? FFTSIZE : FFTHOP, SAMPLERATE);
 
     paletteLabel = new QLabel();
     paletteLabel->setMaximumWidth(40);
@@ -62,6 +88,37 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
     spectrogramLayout->addWidget(scaleLabelRight);
     spectrogramLayout->addWidget(paletteLabel);
 
+    /* Tone tracking, comma separated frequencies, live stations only. The
+     * tracker checks them against Nyquist once the stream announces its rate. */
+
+    QList<double> toneFrequencies;
+    QStringList toneList = tones->text().split(",", QString::SkipEmptyParts);
+
+    for(int i = 0; i < toneList.size(); ++i) {
+
+        double frequency = toneList[i].trimmed().toDouble();
+        if(frequency > 0) toneFrequencies.append(frequency);
+    }
+
+    toneLabel = new QLabel();
+    toneLabel->setMaximumHeight(80);
+
+    if(tcpClient && !toneFrequencies.isEmpty()) {
+
+        toneTracker = new ToneTracker(SAMPLERATE, toneFrequencies);
+        toneStrip = new ToneStrip(toneLabel, toneFrequencies.size());
+
+        if(!toneLog->text().isEmpty()) {
+
+            toneTracker->setLog(toneLog->text());
+        }
+    }
+
+    else {
+
+        toneLabel->hide();
+    }
+
     /* Slider Layout */
 
     sliderLayout = new QGridLayout();
@@ -88,7 +145,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
 
     freqFrom = new QSpinBox();
     freqFrom->setMinimum(0);
-    freqFrom->setMaximum(2755);
+    freqFrom->setMaximum(SAMPLERATE / 2 - 1);
     freqFrom->setValue(FREQFROM);
 
     freqLayout->addWidget(new QLabel("From"), 0, 0);
@@ -97,7 +154,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
 
     freqTo = new QSpinBox();
     freqTo->setMinimum(1);
-    freqTo->setMaximum(2756);
+    freqTo->setMaximum(SAMPLERATE / 2);
     freqTo->setValue(FREQTO);
 
     freqLayout->addWidget(new QLabel("To"), 1, 0);
@@ -110,16 +167,42 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
     freqLayout->addWidget(defaultFreqRangeButton);
     freqLayout->addWidget(freqRangeButton);
 
+    /* Integration Layout */
+
+    integrationLayout = new QGridLayout();
+
+    integrationBox = new QSpinBox();
+    integrationBox->setMinimum(1);
+    integrationBox->setMaximum(64);
+    integrationBox->setValue(1);
+
+    integrationLayout->addWidget(new QLabel("Integrate"), 0, 0);
+    integrationLayout->addWidget(integrationBox, 0, 1);
+    integrationLayout->addWidget(new QLabel("spectra"), 0, 2);
+
+    integrationMode = new QComboBox();
+    integrationMode->addItem("Average", FFT::Average);
+    integrationMode->addItem("Max hold", FFT::MaxHold);
+
+    integrationLayout->addWidget(new QLabel("Mode"), 1, 0);
+    integrationLayout->addWidget(integrationMode, 1, 1);
+
+    exportButton = new QPushButton("Export...");
+    exportButton->setToolTip(QString("Exports the last %1 columns at most, about %2 h with one spectrum per column").arg(HISTORYLENGTH).arg(HISTORYLENGTH * (critical->isChecked() ? FFTSIZE : FFTHOP) / SAMPLERATE / 3600, 0, 'f', 1));
+    integrationLayout->addWidget(exportButton, 2, 1);
+
     /* Settings Layout */
 
     settingsLayout = new QHBoxLayout();
     settingsLayout->addLayout(sliderLayout);
     settingsLayout->addLayout(freqLayout);
+    settingsLayout->addLayout(integrationLayout);
 
     /* Main Layout */
 
     mainLayout = new QVBoxLayout();
     mainLayout->addLayout(spectrogramLayout);
+    mainLayout->addWidget(toneLabel);
     mainLayout->addLayout(settingsLayout);
 
     centralWidget = new QWidget();
@@ -129,12 +212,36 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
 
     /* Connecting signals to slots */
 
-    QObject::connect(tcpClient, SIGNAL(fftDataReady(double*)), fft, SLOT(compute(double*)));
+    if(columnClient) {
+
+        QObject::connect(columnClient, SIGNAL(columnReady(double*)), spectrogram, SLOT(draw(double*)));
+        QObject::connect(columnClient, SIGNAL(columnReady(double*)), history, SLOT(append(double*)));
+        integrationBox->setEnabled(false);
+        integrationMode->setEnabled(false);
+    }
+
+    else {
+
+        QObject::connect(tcpClient, SIGNAL(fftDataReady(double*)), fft, SLOT(compute(double*)));
+        QObject::connect(tcpClient, SIGNAL(sampleRateChanged(double, double)), this, SLOT(setSampleRate(double, double)));
+
+        if(toneTracker) {
+
+            QObject::connect(tcpClient, SIGNAL(samplesReceived(const int16_t*, int)), toneTracker, SLOT(process(const int16_t*, int)));
+            QObject::connect(toneTracker, SIGNAL(updated(const double*, const double*)), toneStrip, SLOT(plot(const double*, const double*)));
+        }
+    }
+
     QObject::connect(fft, SIGNAL(done(double*)), spectrogram, SLOT(draw(double*)));
+    QObject::connect(fft, SIGNAL(done(double*)), history, SLOT(append(double*)));
+    QObject::connect(exportButton, SIGNAL(clicked()), this, SLOT(exportHistory()));
     QObject::connect(brightnessSlider, SIGNAL(valueChanged(int)), spectrogram, SLOT(adjustBrightness(int)));
     QObject::connect(brightnessSlider, SIGNAL(valueChanged(int)), this, SLOT(notifyBrightnessChange(int)));
     QObject::connect(contrastSlider, SIGNAL(valueChanged(int)), spectrogram, SLOT(adjustContrast(int)));
     QObject::connect(contrastSlider, SIGNAL(valueChanged(int)), this, SLOT(notifyContrastChange(int)));
+    QObject::connect(integrationBox, SIGNAL(valueChanged(int)), fft, SLOT(setIntegration(int)));
+    QObject::connect(integrationBox, SIGNAL(valueChanged(int)), spectrogram, SLOT(setIntegration(int)));
+    QObject::connect(integrationMode, SIGNAL(currentIndexChanged(int)), fft, SLOT(setIntegrationMode(int)));
     QObject::connect(defaultFreqRangeButton, SIGNAL(clicked()), this, SLOT(resetFreqRange()));
     QObject::connect(freqRangeButton, SIGNAL(clicked()), this, SLOT(updateFreqRange()));
     QObject::connect(spectrogram, SIGNAL(scalingSpectrogram(QString, int)), this->statusBar(), SLOT(showMessage(QString, int)));
@@ -147,8 +254,12 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), initialized(false
 MainWindow::~MainWindow() {
 
     delete tcpClient;
+    delete columnClient;
     delete fft;
     delete spectrogram;
+    delete history;
+    delete toneTracker;
+    delete toneStrip;
 }
 
 void MainWindow::resizeEvent(QResizeEvent*) {
@@ -205,3 +316,53 @@ void MainWindow::notifyContrastChange(int value) {
     this->statusBar()->showMessage(QString::number(value), 3000);
     paletteLabel->setPixmap(QPixmap::fromImage(spectrogram->generatePalette(paletteLabel->width(), paletteLabel->height())));
 }
+
+/* The snapshot is taken here, the rendering and writing run on the thread pool. */
+void MainWindow::exportHistory() {
+
+    if(history->size() == 0) {
+
+        this->statusBar()->showMessage(tr("Nothing to export yet"), 3000);
+        return;
+    }
+
+    QString path = QFileDialog::getSaveFileName(this, tr("Export history"), QString(), tr("PNG image (*.png);;NumPy array (*.npy)"));
+
+    if(path.isEmpty()) {
+
+        return;
+    }
+
+    Exporter *exporter = new Exporter(history->snapshot(), path, freqFrom->value(), freqTo->value());
+    QObject::connect(exporter, SIGNAL(finished(QString, bool)), this, SLOT(exportFinished(QString, bool)));
+    QObject::connect(exporter, SIGNAL(finished(QString, bool)), exporter, SLOT(deleteLater()));
+    QThreadPool::globalInstance()->start(exporter);
+
+    this->statusBar()->showMessage(tr("Exporting ") + path);
+}
+
+void MainWindow::exportFinished(QString path, bool ok) {
+
+    this->statusBar()->showMessage((ok ? tr("Exported ") : tr("Export failed: ")) + path, 5000);
+}
+
+/* Called when the stream announces its rate: the analysis runs at the
+ * decimated rate, the tone tracker at the input rate. */
+void MainWindow::setSampleRate(double analysisRate, double inputRate) {
+
+    spectrogram->setSampleRate(analysisRate);
+    history->setSampleRate(analysisRate);
+
+    if(toneTracker) {
+
+        toneTracker->setSampleRate(inputRate);
+    }
+
+    /* above the decimator's passband the band is attenuated */
+    double passband = Decimator::passband(inputRate, analysisRate);
+    freqFrom->setMaximum(passband - 1);
+    freqTo->setMaximum(passband);
+    updateFreqRange();
+
+    this->statusBar()->showMessage(QString("Input at %1 Hz, analysed at %2 Hz").arg(inputRate).arg(analysisRate), 5000);
+}
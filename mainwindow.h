@@ -9,8 +9,13 @@
 #include <QFormLayout>
 #include <QLabel>
 #include "tcpclient.h"
+#include "columnclient.h"
 #include "fft.h"
 #include "spectrogram.h"
+#include "history.h"
+#include "exporter.h"
+#include "tonetracker.h"
+#include "tonestrip.h"
 #include <QSpinBox>
 #include <QPushButton>
 #include <QStatusBar>
@@ -20,12 +25,18 @@
 #include <QLineEdit>
 #include <QIntValidator>
 #include <QDialogButtonBox>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QThreadPool>
 #include "palette.h"
 
 #define FFTSIZE 16384
-#define SAMPLERATE 5512.5
+#define FFTHOP (FFTSIZE / 10)
+#define SAMPLERATE 5512.5 // default input rate, and the analysis rate faster streams are decimated to
 #define FREQFROM 0
 #define FREQTO 2756
+#define HISTORYLENGTH 36864 // columns kept for export, about 3 h at FFTHOP and 8 kB per column
 
 class MainWindow : public QMainWindow
 {
@@ -42,6 +53,9 @@ public slots:
     void resetFreqRange();
     void notifyBrightnessChange(int);
     void notifyContrastChange(int);
+    void exportHistory();
+    void exportFinished(QString, bool);
+    void setSampleRate(double, double);
 
 private:
 
@@ -49,23 +63,35 @@ private:
     void initialize();
 
     TcpClient* tcpClient;
+    ColumnClient* columnClient;
     FFT *fft;
     Spectrogram *spectrogram;
+    History *history;
+    ToneTracker *toneTracker;
+    ToneStrip *toneStrip;
 
-    QLabel *spectrogramLabel, *paletteLabel, *scaleLabel, *scaleLabelRight;
+    QLabel *spectrogramLabel, *paletteLabel, *scaleLabel, *scaleLabelRight, *toneLabel;
     QSlider *brightnessSlider, *contrastSlider;
     QSpinBox *freqFrom, *freqTo;
-    QPushButton *freqRangeButton, *defaultFreqRangeButton;
+    QSpinBox *integrationBox;
+    QComboBox *integrationMode;
+    QPushButton *freqRangeButton, *defaultFreqRangeButton, *exportButton;
 
 
     QWidget *centralWidget;
     QVBoxLayout *mainLayout;
     QHBoxLayout *settingsLayout;
-    QGridLayout *sliderLayout, *freqLayout;
+    QGridLayout *sliderLayout, *freqLayout, *integrationLayout;
     QHBoxLayout *spectrogramLayout;
 
     QLineEdit *host;
     QLineEdit *port;
+    QCheckBox *viewer;
+    QSpinBox *taps;
+    QCheckBox *critical;
+    QCheckBox *compressed;
+    QLineEdit *tones;
+    QLineEdit *toneLog;
 
     bool initialized;
 
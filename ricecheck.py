@@ -0,0 +1,99 @@
+import numpy as np
+import os
+import subprocess
+import sys
+import tempfile
+
+from bramsriff import BRAMSCompressor, WAVFile
+
+
+def signals(length, seed=0):
+    """
+    Test signals for the round trip: each predictor order wins somewhere,
+    full scale noise and steps push the Rice parameter up, and clicks on
+    silence force the escape code.
+    """
+    rng = np.random.RandomState(seed)
+    t = np.arange(length)
+    yield "silence", np.zeros(length)
+    yield "tone", 8000 * np.sin(2 * np.pi * 1000 * t / 5512.5)
+    yield "tone and noise", (3000 * np.sin(2 * np.pi * 1000.5 * t / 5512.5)
+                             + rng.normal(0, 200, length))
+    yield "random walk", np.cumsum(rng.randint(-50, 51, length))
+    yield "full scale noise", rng.randint(-32768, 32768, length)
+    yield "steps", np.where((t // 7) % 2, 32767, -32768)
+    yield "clicks", np.where(t % 500 == 0, 32767, 0)
+
+
+def encode(samples, block):
+    """
+    Blocks as sent by bramsriff.py --compress, with the last one at least
+    two samples long.
+    """
+    compressor = BRAMSCompressor()
+    return b"".join(
+        compressor.encode(samples[i:i + block])
+        for i in range(0, len(samples) - 1, block))
+
+
+def decode(program, stream):
+    """
+    Decodes `stream` with RiceDecoder through `program` --decode.
+    """
+    with tempfile.TemporaryDirectory() as directory:
+        source = os.path.join(directory, "stream.rice")
+        target = os.path.join(directory, "samples.raw")
+        with open(source, "wb") as f:
+            f.write(stream)
+        subprocess.check_call(
+            [program, "--decode", source, "--output", target],
+            stdout=subprocess.DEVNULL)
+        return np.fromfile(target, dtype="<i2")
+
+
+if __name__ == "__main__":
+
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description='Round trip BRAMSCompressor through RiceDecoder')
+    parser.add_argument(
+        'program', type=str, help='brams_waterfall executable')
+    parser.add_argument(
+        "-f", "--file", help="also check the samples of a wav file",
+        type=str)
+    args = parser.parse_args()
+
+    tests = list(signals(20000))
+
+    if args.file:
+        b, pps, data = WAVFile(args.file).read()
+        tests.append((args.file, data.signal))
+
+    failures = 0
+
+    for name, samples in tests:
+
+        samples = np.clip(np.round(samples), -32768, 32767).astype("<i2")
+
+        # 8192 is RICE_MAX_BLOCK, 2 the shortest block the format allows
+        for block in (2, 3, 1024, 8192):
+
+            stream = encode(samples, block)
+            decoded = decode(args.program, stream)
+            ok = np.array_equal(decoded, samples)
+            failures += not ok
+
+            print("{:<20} block {:>5}: {:>3.0f}% of raw, {}".format(
+                name[-20:], block, 100.0 * len(stream) / (2 * len(samples)),
+                "ok" if ok else "MISMATCH"))
+
+        # a receiver joining mid-stream resumes at the next block
+        stream = encode(samples, 1024)
+        decoded = decode(args.program, stream[5:])
+        ok = np.array_equal(decoded, samples[1024:])
+        failures += not ok
+        print("{:<20} resync     : {}".format(
+            name[-20:], "ok" if ok else "MISMATCH"))
+
+    sys.exit(1 if failures else 0)
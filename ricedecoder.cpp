@@ -0,0 +1,196 @@
+#include "ricedecoder.h"
+
+static inline uint16_t readUInt16(const uchar *p) {
+
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint64_t readBigEndian64(const uchar *p) {
+
+    uint64_t value = 0;
+
+    for(int i = 0; i < 8; ++i) {
+
+        value = (value << 8) | p[i];
+    }
+
+    return value;
+}
+
+static inline int leadingOnes(uint64_t word) {
+
+#ifdef __GNUC__
+    return ~word ? __builtin_clzll(~word) : 64;
+#else
+    int n = 0;
+    while(n < 64 && (word & (1ULL << (63 - n)))) n++;
+    return n;
+#endif
+}
+
+RiceDecoder::RiceDecoder() : blocks(0), errors(0) {
+
+    /* 8 spare bytes so the bit reader can always load a whole word */
+    payload = new uchar[RICE_MAX_BLOCK * 6 + 8];
+    residuals = new uint32_t[RICE_MAX_BLOCK];
+}
+
+RiceDecoder::~RiceDecoder() {
+
+    delete[] payload;
+    delete[] residuals;
+}
+
+/* Drops any partial block, e.g. when the connection was lost. */
+void RiceDecoder::reset() {
+
+    input.clear();
+}
+
+unsigned long RiceDecoder::blockCount() const {
+
+    return blocks;
+}
+
+unsigned long RiceDecoder::errorCount() const {
+
+    return errors;
+}
+
+/* Appends the int16 samples of every complete block of `data` to `samples`. */
+void RiceDecoder::decode(const QByteArray &data, QByteArray &samples) {
+
+    input.append(data);
+
+    int offset = 0;
+
+    while(input.length() - offset >= RICE_HEADER) {
+
+        const uchar *block = (const uchar *) input.constData() + offset;
+
+        if(memcmp(block, RICE_MAGIC, 4) != 0) {
+
+            /* out of sync, skipping to the next candidate magic */
+            int next = input.indexOf(RICE_MAGIC, offset + 1);
+            errors++;
+            offset = next < 0 ? input.length() - 3 : next;
+            continue;
+        }
+
+        int length = readUInt16(block + 8);
+
+        if(input.length() - offset < RICE_HEADER + length) {
+
+            break;
+        }
+
+        if(decodeBlock(block, samples)) {
+
+            offset += RICE_HEADER + length;
+            blocks++;
+        }
+
+        else {
+
+            std::cout << "dropping corrupt compressed block" << std::endl;
+            errors++;
+            offset += 4;
+        }
+    }
+
+    input.remove(0, offset);
+}
+
+bool RiceDecoder::decodeBlock(const uchar *block, QByteArray &samples) {
+
+    unsigned int count = readUInt16(block + 4);
+    unsigned int order = block[6];
+    unsigned int k = block[7];
+    unsigned int length = readUInt16(block + 8);
+
+    if(count < 2 || count > RICE_MAX_BLOCK || order > 2 || k > 20 || length > RICE_MAX_BLOCK * 6) {
+
+        return false;
+    }
+
+    memcpy(payload, block + RICE_HEADER, length);
+    memset(payload + length, 0, 8);
+
+    /* entropy decoding: one word load per residual, a code is at most 44 bits */
+    unsigned int n = count - 2;
+    uint64_t position = 0;
+
+    for(unsigned int i = 0; i < n; ++i) {
+
+        uint64_t word = readBigEndian64(payload + (position >> 3)) << (position & 7);
+        int ones = leadingOnes(word);
+
+        if(ones >= RICE_ESCAPE) {
+
+            residuals[i] = (word << RICE_ESCAPE) >> (64 - RICE_ESCAPE_BITS);
+            position += RICE_ESCAPE + RICE_ESCAPE_BITS;
+        }
+
+        else {
+
+            uint32_t low = k > 0 ? (word << (ones + 1)) >> (64 - k) : 0;
+            residuals[i] = ((uint32_t) ones << k) | low;
+            position += ones + 1 + k;
+        }
+    }
+
+    /* the encoder writes exactly the bytes used, padding the last one with zeros */
+    if((position + 7) / 8 != length || ((position & 7) && (payload[length - 1] & (0xFF >> (position & 7))))) {
+
+        return false;
+    }
+
+    /* zigzag back to signed residuals, a separate pass that vectorizes */
+    int32_t *e = (int32_t *) residuals;
+
+    for(unsigned int i = 0; i < n; ++i) {
+
+        e[i] = (int32_t) (residuals[i] >> 1) ^ -(int32_t) (residuals[i] & 1);
+    }
+
+    int previousLength = samples.length();
+    samples.resize(previousLength + count * sizeof(int16_t));
+    int16_t *x = (int16_t *) (samples.data() + previousLength);
+
+    x[0] = (int16_t) readUInt16(block + 10);
+    x[1] = (int16_t) readUInt16(block + 12);
+
+    if(order == 0) {
+
+        for(unsigned int i = 0; i < n; ++i) {
+
+            x[i + 2] = e[i];
+        }
+    }
+
+    else if(order == 1) {
+
+        int32_t value = x[1];
+
+        for(unsigned int i = 0; i < n; ++i) {
+
+            value += e[i];
+            x[i + 2] = value;
+        }
+    }
+
+    else {
+
+        int32_t value = x[1];
+        int32_t slope = x[1] - x[0];
+
+        for(unsigned int i = 0; i < n; ++i) {
+
+            slope += e[i];
+            value += slope;
+            x[i + 2] = value;
+        }
+    }
+
+    return true;
+}
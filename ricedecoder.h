@@ -0,0 +1,56 @@
+#ifndef RICEDECODER_H
+#define RICEDECODER_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <QByteArray>
+
+#define RICE_MAGIC "BRZ1"
+#define RICE_HEADER 14
+#define RICE_MAX_BLOCK 8192
+#define RICE_ESCAPE 24
+#define RICE_ESCAPE_BITS 20
+
+/* Decoder for the compressed sample stream written by bramsriff.py --compress.
+ *
+ * The stream is a sequence of independent blocks (little endian):
+ *   "BRZ1", uint16 count, uint8 order, uint8 k, uint16 payload bytes,
+ *   int16 x[0], int16 x[1], payload.
+ * The payload holds the count - 2 residuals of a fixed polynomial predictor of
+ * the given order (0 to 2), zigzag mapped and Rice coded with parameter k,
+ * MSB first: q = u >> k ones, a zero, then the k low bits. A quotient of
+ * RICE_ESCAPE or more is written as RICE_ESCAPE ones followed by u on
+ * RICE_ESCAPE_BITS bits.
+ *
+ * Every block starts from raw samples, so after a reconnect or garbage the
+ * decoder just looks for the next magic and carries on.
+ *
+ * The format has no checksum. A block is only accepted if its header is in
+ * range and its residuals use exactly the payload bytes with zero padding,
+ * but after a resync a "BRZ1" inside a payload can still pass these checks
+ * and decode as one block of garbage samples. */
+class RiceDecoder {
+
+public:
+
+    RiceDecoder();
+    ~RiceDecoder();
+
+    void reset();
+    void decode(const QByteArray&, QByteArray&);
+    unsigned long blockCount() const;
+    unsigned long errorCount() const;
+
+private:
+
+    bool decodeBlock(const uchar*, QByteArray&);
+
+    QByteArray input;
+    uchar *payload;
+    uint32_t *residuals;
+    unsigned long blocks, errors;   // decoded blocks, and resyncs plus rejected blocks
+};
+
+#endif // RICEDECODER_H
@@ -1,14 +1,18 @@
 #include "spectrogram.h"
 
-Spectrogram::Spectrogram(QLabel *label, int fftSize, double sampleRate) : label(label), frameSize(fftSize / 2), current(0) {
+Spectrogram::Spectrogram(QLabel *label, int fftSize, int hop, double sampleRate) : label(label), frameSize(fftSize / 2), current(0), hop(hop), integration(1) {
     
     frameCount = 864;
     pixelHeight = label->height();
 
     image = new QImage(frameCount, frameSize, QImage::Format_RGB16);
+    image->fill(QColor(0, 0, 0));
 
     frames = new double* [frameCount];
-    dframe = new double[pixelHeight];
+    dframe = new float[pixelHeight];
+    noiseFloor = new float[frameSize];
+    rowFloor = new float[pixelHeight];
+    column = new unsigned char[pixelHeight];
 
     for(int i = 0; i < frameCount; ++i) {
         
@@ -17,9 +21,13 @@ Spectrogram::Spectrogram(QLabel *label, int fftSize, double sampleRate) : label(
 
     df = sampleRate / fftSize;
     allFrames = false;
-    average = 0;
     freqChanged = true;
-    max = -std::numeric_limits<double>::max();
+    floorValid = false;
+    peak = 1;
+    range = MIN_DYNAMIC_RANGE;
+    updateRates();
+    updateColorTable();
+    timer.start();
 }
 
 Spectrogram::~Spectrogram() {
@@ -31,7 +39,10 @@ Spectrogram::~Spectrogram() {
 
     delete image;
     delete frames;
-    delete dframe;
+    delete[] dframe;
+    delete[] noiseFloor;
+    delete[] rowFloor;
+    delete[] column;
 }
 
 QImage Spectrogram::generatePalette(unsigned int width, unsigned int height) {
@@ -84,14 +95,107 @@ QImage Spectrogram::generateFreqScale(unsigned int width, unsigned int height) {
     return freqScaleImage;
 }
 
-double Spectrogram::dbfs(double data) {
+/* Packs the palette, with brightness and contrast applied, as RGB565 pixels. */
+void Spectrogram::updateColorTable() {
 
-    return 10 * log10(abs(data) / max);
+    for(int i = 0; i < 256; ++i) {
+
+        QColor color = palette[i];
+        colorTable[i] = ((color.red() >> 3) << 11) | ((color.green() >> 2) << 5) | (color.blue() >> 3);
+    }
 }
 
-long Spectrogram::computeColor(double dbfs)
-{
-    return ((dbfs - average) / abs(average)) * 255;
+/* Maps the reduced column to palette indices (dB above the noise floor over the
+ * current range) and writes it at `current`: the image is a ring of columns, so
+ * nothing scrolls and a column costs one pixel per row. */
+void Spectrogram::renderColumn() {
+
+    float scale = (float) (20 * log10(2.0) * 255 / range);
+
+    for(int k = 0; k < pixelHeight; ++k) {
+
+        float value = fastLog2(dframe[k] / rowFloor[k]) * scale;
+        value = value > 0 ? value : 0;
+        value = value < 255 ? value : 255;
+        column[k] = (unsigned char) value;
+    }
+
+    for(int j = 0; j < pixelHeight; ++j) {
+
+        ((quint16 *) image->scanLine(j))[current] = colorTable[column[pixelHeight - 1 - j]];
+    }
+}
+
+/* Draws the ring scaled to the label, oldest column first: the columns from
+ * `current` to the end of the image, then those before it. */
+void Spectrogram::present() {
+
+    int width = label->width();
+    int height = label->height();
+    int older = frameCount - current;
+    double scale = (double) width / frameCount;
+
+    QPixmap pixmap(width, height);
+    QPainter p(&pixmap);
+    p.drawImage(QRectF(0, 0, older * scale, height), *image, QRectF(current, 0, older, pixelHeight));
+    p.drawImage(QRectF(older * scale, 0, current * scale, height), *image, QRectF(0, 0, current, pixelHeight));
+    p.end();
+
+    label->setPixmap(pixmap);
+}
+
+/* Converts the per second rates to the time between columns, `hop` samples
+ * per spectrum and `integration` spectra per column. */
+void Spectrogram::updateRates() {
+
+    double interval = (double) hop * integration / (2 * frameSize * df);
+
+    attack = 1 - pow(1 - FLOOR_ATTACK, interval);
+    release = 1 - pow(1 - FLOOR_RELEASE, interval);
+    decay = pow(PEAK_DECAY, interval);
+}
+
+/* Tracks a noise floor per FFT bin. It follows drops quickly and rises slowly,
+ * so it settles near a low percentile of each bin and ignores short echoes.
+ * Being per bin, it survives resizing and frequency range changes. */
+void Spectrogram::updateNoiseFloor(const double *frame) {
+
+    if(!floorValid) {
+
+        for(int j = 0; j < frameSize; ++j) {
+
+            noiseFloor[j] = frame[j] > FLOOR_EPSILON ? frame[j] : FLOOR_EPSILON;
+        }
+
+        floorValid = true;
+    }
+
+    for(int j = 0; j < frameSize; ++j) {
+
+        float d = (float) frame[j] - noiseFloor[j];
+        float level = noiseFloor[j] + (d < 0 ? attack : release) * d;
+        noiseFloor[j] = level > FLOOR_EPSILON ? level : FLOOR_EPSILON;
+    }
+}
+
+/* Follows the peak ratio of the rows to their floor with a decaying reference,
+ * which forgets interference spikes after a while instead of darkening the
+ * display forever. */
+void Spectrogram::updateRange() {
+
+    float columnPeak = 1;
+
+    for(int k = 0; k < pixelHeight; ++k) {
+
+        float ratio = dframe[k] / rowFloor[k];
+        columnPeak = ratio > columnPeak ? ratio : columnPeak;
+    }
+
+    peak = peak * decay;
+    if(columnPeak > peak) peak = columnPeak;
+
+    range = 20 * log10(peak);
+    if(range < MIN_DYNAMIC_RANGE) range = MIN_DYNAMIC_RANGE;
 }
 
 int Spectrogram::hertzToPixel(double hertz, unsigned int height) {
@@ -113,13 +217,18 @@ void Spectrogram::draw(double *data) {
     {
         emit scalingSpectrogram("Rescaling spectrogram...", 0);
         pixelHeight = label->height();
-        delete dframe;
-        dframe = new double[pixelHeight];
+        delete[] dframe;
+        delete[] rowFloor;
+        delete[] column;
+        dframe = new float[pixelHeight];
+        rowFloor = new float[pixelHeight];
+        column = new unsigned char[pixelHeight];
         emit scalingSpectrogram("Spectrogram rescaled", 3000);
         freqChanged = false;
     }
 
-    double valueAverage = 0;
+    updateNoiseFloor(frames[current]);
+
     double f = ((freqTo - freqFrom) / df) / pixelHeight;
     double start = freqFrom / df;
     double end = freqTo / df;
@@ -127,6 +236,7 @@ void Spectrogram::draw(double *data) {
     for(int k = 0; k < pixelHeight; ++k) {
 
         double m = 0;
+        double level = 0;
         int n = 0;
 
         for(int j = start + (k * f); j < start + (k * f) + f; ++j) {
@@ -134,32 +244,17 @@ void Spectrogram::draw(double *data) {
             if(j >= 0 && j < end) {
 
                 m += frames[current][j];
+                level += noiseFloor[j];
                 n++;
             }
         }
 
-        dframe[k] = m / n;
-        if(dframe[k] > max) max = dframe[k];
-        double value = dbfs(dframe[k]);
-
-        valueAverage += value;
-        if(value > 0) value = 0;
-        if(value < average) value = average;
-        image->setPixel(frameCount - 1, pixelHeight - k, palette[computeColor(value)].rgb());
+        dframe[k] = n > 0 ? m / n : 0;
+        rowFloor[k] = n > 0 ? level / n : FLOOR_EPSILON;
     }
 
-    valueAverage /= pixelHeight;
-    average = (valueAverage + average) / 2;
-
-    for(int i = 0; i < frameCount - 1; ++i) {
-
-        for(int j = 0; j < pixelHeight; ++j) {
-
-            image->setPixel(i, j, image->pixel(i + 1, j));
-        }
-    } 
-
-    label->setPixmap(QPixmap::fromImage(*image).copy(0, 0, frameCount, pixelHeight).scaled(label->width(), label->height(), Qt::IgnoreAspectRatio));
+    updateRange();
+    renderColumn();
 
     current++;
 
@@ -168,16 +263,40 @@ void Spectrogram::draw(double *data) {
         allFrames = true;
         current = 0;
     }
+
+    if(timer.hasExpired(SPECTROGRAM_REFRESH)) {
+
+        present();
+        timer.restart();
+    }
 }
 
 void Spectrogram::adjustBrightness(int value) {
     
     palette.setBrightness(value);
+    updateColorTable();
 }
 
 void Spectrogram::adjustContrast(int value) {
     
     palette.setContrast(value);
+    updateColorTable();
+}
+
+/* The bins keep their count, only their width changes; the next column rescales
+ * and the floor is seeded again, as the bins no longer cover the same bands. */
+void Spectrogram::setSampleRate(double sampleRate) {
+
+    df = sampleRate / (2 * frameSize);
+    freqChanged = true;
+    floorValid = false;
+    updateRates();
+}
+
+void Spectrogram::setIntegration(int count) {
+
+    integration = count > 1 ? count : 1;
+    updateRates();
 }
 
 void Spectrogram::setFreqRange(unsigned int freqFrom, unsigned int freqTo) {
@@ -7,7 +7,16 @@
 #include <iostream>
 #include <cmath>
 #include <QPainter>
+#include <QElapsedTimer>
 #include "palette.h"
+#include "fastlog.h"
+
+#define FLOOR_ATTACK 0.16       // per second, when a bin drops below its floor
+#define FLOOR_RELEASE 0.0067    // per second, when a bin sits above its floor
+#define FLOOR_EPSILON 1e-6f
+#define PEAK_DECAY 0.9933       // per second
+#define MIN_DYNAMIC_RANGE 10.0  // dB above the noise floor mapped to full scale
+#define SPECTROGRAM_REFRESH 40  // ms between label updates
 
 class Spectrogram : public QObject
 {
@@ -15,7 +24,7 @@ class Spectrogram : public QObject
 
 public:
 
-    Spectrogram(QLabel*, int, double);
+    Spectrogram(QLabel*, int, int, double);
     ~Spectrogram();
     void setFreqRange(unsigned int, unsigned int);
     QImage generatePalette(unsigned int, unsigned int);
@@ -31,17 +40,24 @@ public slots:
     void draw(double*);
     void adjustBrightness(int);
     void adjustContrast(int);
+    void setSampleRate(double);
+    void setIntegration(int);
 
 private:
     
     int hertzToPixel(double, unsigned int);
     double pixelToHertz(int, unsigned int);
-    long computeColor(double);
-    double dbfs(double);
+    void updateRates();
+    void updateNoiseFloor(const double*);
+    void updateRange();
+    void updateColorTable();
+    void renderColumn();
+    void present();
 
 
     QLabel *label;
     int frameSize, current, fftSize;
+    int hop, integration;
     int pixelHeight;
     int frameCount;
 
@@ -49,15 +65,23 @@ private:
     
     Palette palette;
     QImage *image;
+    QElapsedTimer timer;
     double **frames;
-    double *dframe;
+    float *dframe;
+    float *noiseFloor;
+    float *rowFloor;
+    unsigned char *column;
+    quint16 colorTable[256];
 
     double df;
     
     bool allFrames;
     bool freqChanged;
-    double average;
-    double max;
+    bool floorValid;
+    float attack, release;
+    double decay;
+    double peak;
+    double range;
 };
 
 #endif // SPECTROGRAM_H
@@ -1,14 +1,20 @@
 #include "tcpclient.h"
 
-TcpClient::TcpClient(unsigned int fftSize, QString host, unsigned short int port) : socket(this), fftSize(fftSize), fftSize90(round((double)fftSize / 10)) {
+/* `sampleRate` is the rate assumed for streams without a preamble, and the
+ * analysis rate that faster streams are decimated to. */
+TcpClient::TcpClient(unsigned int fftSize, unsigned int hop, QString host, unsigned short int port, double sampleRate) : socket(this), compressed(false), preambleChecked(false), host(host), port(port), fftSize(fftSize), hop(hop), inputRate(sampleRate), targetRate(sampleRate) {
     
-    idata = new int16_t[fftSize];
-    data = new double[fftSize];
+    decimator = new Decimator(sampleRate, targetRate);
 
     socket.connectToHost(QHostAddress(host), port);
     QObject::connect(&socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
     QObject::connect(&socket, SIGNAL(connected()), this, SLOT(connected()));
     QObject::connect(&socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    QObject::connect(&socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(connectionError(QAbstractSocket::SocketError)));
+
+    retryDelay = RECONNECT_DELAY;
+    reconnectTimer.setSingleShot(true);
+    QObject::connect(&reconnectTimer, SIGNAL(timeout()), this, SLOT(reconnect()));
 
     length = 0;
     timer.start();
@@ -16,41 +22,183 @@ TcpClient::TcpClient(unsigned int fftSize, QString host, unsigned short int port
 
 TcpClient::~TcpClient() {
 
-    delete idata;
-    delete data;
+    delete decimator;
 }
 
-void TcpClient::connected() {}
-void TcpClient::disconnected() {}
+void TcpClient::connected() {
+
+    std::cout << "connected to " << host.toStdString() << ":" << port << std::endl;
+    retryDelay = RECONNECT_DELAY;
+}
+
+/* A compressed stream resumes at the next block, so only the partial block is lost. */
+void TcpClient::disconnected() {
+
+    std::cout << "disconnected, reconnecting" << std::endl;
+    decoder.reset();
+
+    if(byteArray.length() % sizeof(int16_t)) {
+
+        byteArray.chop(1);
+    }
+
+    /* the station sends its preamble again on the new connection */
+    preambleChecked = false;
+    head.clear();
+
+    reconnectTimer.start(retryDelay);
+}
+
+/* A failed attempt reports an error but no disconnection, so the retry is
+ * scheduled here too. Restarting the timer keeps a single pending attempt. */
+void TcpClient::connectionError(QAbstractSocket::SocketError) {
+
+    if(socket.state() == QAbstractSocket::UnconnectedState) {
+
+        std::cout << "connection failed: " << socket.errorString().toStdString() << ", retrying in " << retryDelay / 1000 << " s" << std::endl;
+        reconnectTimer.start(retryDelay);
+    }
+}
+
+/* Each attempt doubles the delay before the next one, up to RECONNECT_MAX_DELAY. */
+void TcpClient::reconnect() {
+
+    if(socket.state() != QAbstractSocket::UnconnectedState) {
+
+        return;
+    }
+
+    retryDelay = qMin(2 * retryDelay, RECONNECT_MAX_DELAY);
+    socket.connectToHost(QHostAddress(host), port);
+}
+
+/* Expects Rice coded blocks (see RiceDecoder) instead of raw samples. */
+void TcpClient::setCompressed(bool compressed) {
+
+    this->compressed = compressed;
+    decoder.reset();
+}
+
+/* Sets up the decimation from `rate` to the analysis band and announces both
+ * rates. Every reconnection repeats the preamble, and an announcement resets
+ * the history and the noise floor downstream, so an unchanged rate is ignored. */
+void TcpClient::setInputRate(double rate) {
+
+    if(rate <= 0 || rate == inputRate) {
+
+        return;
+    }
+
+    inputRate = rate;
+    delete decimator;
+    decimator = new Decimator(rate, targetRate);
+    samples.clear();
+
+    std::cout << "input at " << rate << " Hz, decimated by " << decimator->factor() << " to " << decimator->outputRate() << " Hz" << std::endl;
+
+    emit sampleRateChanged(decimator->outputRate(), rate);
+}
+
+/* Stations may open the stream with a preamble: "BRSR", float64 sample rate,
+ * uint32 flags (bit 0: compressed). Without it the stream is taken as raw
+ * samples at the default rate. Returns false while more bytes are needed. */
+bool TcpClient::readPreamble() {
+
+    if(head.length() < 4) {
+
+        return false;
+    }
+
+    if(!head.startsWith(STREAM_MAGIC)) {
+
+        preambleChecked = true;
+        return true;
+    }
+
+    if(head.length() < STREAM_PREAMBLE) {
+
+        return false;
+    }
+
+    double rate;
+    quint32 flags;
+    memcpy(&rate, head.constData() + 4, sizeof(double));
+    memcpy(&flags, head.constData() + 12, sizeof(quint32));
+    head.remove(0, STREAM_PREAMBLE);
+    preambleChecked = true;
+
+    setCompressed(flags & 1);
+    setInputRate(rate);
+
+    return true;
+}
 
 void TcpClient::onReadyRead() {
 
+    QByteArray incoming = socket.readAll();
+
+    if(!preambleChecked) {
+
+        head.append(incoming);
+
+        if(!readPreamble()) {
+
+            return;
+        }
+
+        incoming = head;
+        head.clear();
+    }
+
     int previousLength = byteArray.length();
-    byteArray.append(socket.readAll());
+
+    if(compressed) {
+
+        decoder.decode(incoming, byteArray);
+    }
+
+    else {
+
+        byteArray.append(incoming);
+    }
+
     length += byteArray.length() - previousLength;
 
+    /* new whole samples go to per-sample consumers at the input rate, then
+     * through the decimator into the analysis buffer */
+    int count = byteArray.length() / sizeof(int16_t);
+
+    if(count > 0) {
+
+        const int16_t *received = (const int16_t *) byteArray.constData();
+        emit samplesReceived(received, count);
+        decimator->process(received, count, samples);
+        byteArray.remove(0, count * sizeof(int16_t));
+    }
+
     if(timer.hasExpired(5000)) {
 
-        std::cout << ((double) length / timer.elapsed()) * 500 << " samples/second" << std::endl;
+        std::cout << ((double) length / timer.elapsed()) * 500 << " samples/second";
+
+        if(compressed) {
+
+            std::cout << ", " << decoder.blockCount() << " blocks, " << decoder.errorCount() << " errors";
+        }
+
+        std::cout << std::endl;
         length = 0;
         timer.restart();
     }
     
-    if(byteArray.length() >= sizeof(int16_t) * fftSize) {
-
-        getDataFromByteArray();
-    }
+    emitFrames();
 }
 
-void TcpClient::getDataFromByteArray() {
+/* Emits every complete frame of the analysis buffer, advancing by `hop`. */
+void TcpClient::emitFrames() {
 
-    memcpy(idata, byteArray.data(), sizeof(int16_t) * fftSize);
-    
-    for(unsigned int i = 0; i < fftSize; ++i) {
+    while(samples.size() >= (int) fftSize) {
 
-        data[i] = idata[i];
+        emit fftDataReady(samples.data());
+        samples.remove(0, hop);
     }
-
-    emit fftDataReady(data);
-    byteArray.remove(0, sizeof(int16_t) * fftSize90); 
 }
\ No newline at end of file
@@ -10,8 +10,17 @@
 #include <QTcpSocket>
 #include <QHostAddress>
 #include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+
+#include "ricedecoder.h"
+#include "decimator.h"
 
 #define FFTSIZE 16384
+#define STREAM_MAGIC "BRSR"
+#define STREAM_PREAMBLE 16
+#define RECONNECT_DELAY 2000
+#define RECONNECT_MAX_DELAY 60000
 
 
 class TcpClient : public QObject {
@@ -23,29 +32,43 @@ public slots:
     void onReadyRead();
     void connected();
     void disconnected();
+    void connectionError(QAbstractSocket::SocketError);
+    void reconnect();
     
 
 public:
 
-    TcpClient(unsigned int, QString, unsigned short int);
+    TcpClient(unsigned int, unsigned int, QString, unsigned short int, double);
     ~TcpClient();
 
-    void getDataFromByteArray();
+    void emitFrames();
+    void setCompressed(bool);
+    void setInputRate(double);
 
 
 signals:
 
     void fftDataReady(double*);
+    void samplesReceived(const int16_t*, int);
+    void sampleRateChanged(double, double);
 
 private:
 
-    int16_t* idata;
-    double* data;
+    bool readPreamble();
+
     QTcpSocket socket;
-    QByteArray byteArray;
-    unsigned int fftSize, fftSize90;
+    QByteArray byteArray, head;
+    RiceDecoder decoder;
+    Decimator *decimator;
+    QVector<double> samples;
+    bool compressed, preambleChecked;
+    QString host;
+    unsigned short int port;
+    unsigned int fftSize, hop;
+    double inputRate, targetRate;
     QElapsedTimer timer;
-    int length;
+    QTimer reconnectTimer;
+    int length, retryDelay;
 };
 
 #endif // DATAGENERATOR_H
@@ -0,0 +1,68 @@
+#include "tonestrip.h"
+
+static const QRgb toneColors[] = { qRgb(255, 255, 0), qRgb(0, 255, 255), qRgb(255, 0, 255), qRgb(255, 255, 255) };
+
+ToneStrip::ToneStrip(QLabel *label, int tones) : label(label), tones(tones), peak(0) {
+
+    height = label->maximumHeight();
+    image = new QImage(STRIP_LENGTH, height, QImage::Format_RGB32);
+    image->fill(QColor(0, 0, 0));
+
+    previous = new int[tones];
+
+    for(int k = 0; k < tones; ++k) {
+
+        previous[k] = height - 1;
+    }
+
+    timer.start();
+}
+
+ToneStrip::~ToneStrip() {
+
+    delete image;
+    delete[] previous;
+}
+
+void ToneStrip::plot(const double *amplitude, const double *) {
+
+    int x = STRIP_LENGTH - 1;
+
+    for(int j = 0; j < height; ++j) {
+
+        QRgb *line = (QRgb *) image->scanLine(j);
+        memmove(line, line + 1, x * sizeof(QRgb));
+        line[x] = qRgb(0, 0, 0);
+    }
+
+    peak -= STRIP_PEAK_DECAY;
+
+    for(int k = 0; k < tones; ++k) {
+
+        if(amplitude[k] > peak) peak = amplitude[k];
+    }
+
+    for(int k = 0; k < tones; ++k) {
+
+        int y = (peak - amplitude[k]) / STRIP_RANGE * (height - 1);
+        if(y < 0) y = 0;
+        if(y > height - 1) y = height - 1;
+
+        /* joining to the previous point so fast fades stay continuous */
+        int from = y < previous[k] ? y : previous[k];
+        int to = y < previous[k] ? previous[k] : y;
+
+        for(int j = from; j <= to; ++j) {
+
+            ((QRgb *) image->scanLine(j))[x] = toneColors[k % 4];
+        }
+
+        previous[k] = y;
+    }
+
+    if(timer.hasExpired(STRIP_REFRESH)) {
+
+        label->setPixmap(QPixmap::fromImage(*image).scaled(label->width(), label->height(), Qt::IgnoreAspectRatio));
+        timer.restart();
+    }
+}
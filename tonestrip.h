@@ -0,0 +1,41 @@
+#ifndef TONESTRIP_H
+#define TONESTRIP_H
+
+#include <QObject>
+#include <QImage>
+#include <QLabel>
+#include <QColor>
+#include <QElapsedTimer>
+
+#define STRIP_LENGTH 1024
+#define STRIP_RANGE 60.0        // dB shown below the decaying peak
+#define STRIP_PEAK_DECAY 0.01   // dB per update
+#define STRIP_REFRESH 40        // ms between label updates
+
+/* Scrolling amplitude traces of the tracked tones, one column per
+ * ToneTracker update, drawn under the waterfall. */
+class ToneStrip : public QObject {
+
+    Q_OBJECT
+
+public slots:
+
+    void plot(const double*, const double*);
+
+public:
+
+    ToneStrip(QLabel*, int);
+    ~ToneStrip();
+
+private:
+
+    QLabel *label;
+    QImage *image;
+    QElapsedTimer timer;
+
+    int tones, height;
+    int *previous;
+    double peak;
+};
+
+#endif // TONESTRIP_H
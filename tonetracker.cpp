@@ -0,0 +1,193 @@
+#include "tonetracker.h"
+
+ToneTracker::ToneTracker(double sampleRate, QList<double> frequencies) : tones(frequencies.size()), position(0), block(0), window(0), blockSize(1), sample(0), origin(-1), frequencies(frequencies) {
+
+    stepRe = new double[tones];
+    stepIm = new double[tones];
+    lastRe = new double[tones];
+    lastIm = new double[tones];
+    stateRe = new double[tones];
+    stateIm = new double[tones];
+    rotorRe = new double[tones];
+    rotorIm = new double[tones];
+    turnRe = new double[tones];
+    turnIm = new double[tones];
+    amplitude = new double[tones];
+    phase = new double[tones];
+    active = new bool[tones];
+    delay = 0;
+
+    setSampleRate(sampleRate);
+}
+
+/* Recomputes the coefficients for the tones and restarts the sliding windows. */
+void ToneTracker::setSampleRate(double sampleRate) {
+
+    rate = sampleRate;
+    sample = 0;
+    origin = -1;
+
+    window = round(TONE_WINDOW * sampleRate);
+    blockSize = round(TONE_BLOCK * sampleRate);
+    if(window < 1) window = 1;
+    if(blockSize < 1) blockSize = 1;
+
+    delete[] delay;
+    delay = new float[window];
+
+    double r = pow(TONE_DAMPING, 1 / sampleRate);
+    double rN = pow(r, window);
+
+    for(int k = 0; k < tones; ++k) {
+
+        double omega = 2 * M_PI * frequencies[k] / sampleRate;
+        active[k] = frequencies[k] < sampleRate / 2;
+
+        if(!active[k]) {
+
+            std::cout << "tone " << frequencies[k] << " Hz is above the Nyquist frequency of " << sampleRate / 2 << " Hz, not tracked" << std::endl;
+        }
+
+        stepRe[k] = r * cos(omega);
+        stepIm[k] = r * sin(omega);
+        lastRe[k] = rN * cos(omega * window);
+        lastIm[k] = rN * sin(omega * window);
+        turnRe[k] = cos(omega);
+        turnIm[k] = -sin(omega);
+        rotorRe[k] = 1;
+        rotorIm[k] = 0;
+        stateRe[k] = 0;
+        stateIm[k] = 0;
+    }
+
+    for(unsigned int i = 0; i < window; ++i) {
+
+        delay[i] = 0;
+    }
+
+    position = 0;
+    block = 0;
+}
+
+ToneTracker::~ToneTracker() {
+
+    delete[] stepRe;
+    delete[] stepIm;
+    delete[] lastRe;
+    delete[] lastIm;
+    delete[] stateRe;
+    delete[] stateIm;
+    delete[] rotorRe;
+    delete[] rotorIm;
+    delete[] turnRe;
+    delete[] turnIm;
+    delete[] amplitude;
+    delete[] phase;
+    delete[] active;
+    delete[] delay;
+
+    logStream.flush();
+}
+
+bool ToneTracker::setLog(QString path) {
+
+    log.setFileName(path);
+
+    if(!log.open(QIODevice::WriteOnly | QIODevice::Text)) {
+
+        std::cout << "cannot open tone log " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    logStream.setDevice(&log);
+    logStream << "time_ms,sample";
+
+    for(int k = 0; k < tones; ++k) {
+
+        logStream << "," << frequencies[k] << "_db," << frequencies[k] << "_phase";
+    }
+
+    logStream << "\n";
+
+    return true;
+}
+
+void ToneTracker::process(const int16_t *samples, int n) {
+
+    /* the last of these samples was taken about now */
+    double now = QDateTime::currentMSecsSinceEpoch();
+
+    if(origin < 0 || now - (origin + 1000.0 * (sample + n) / rate) > TONE_RESYNC_MS) {
+
+        origin = now - 1000.0 * (sample + n) / rate;
+    }
+
+    for(int i = 0; i < n; ++i) {
+
+        double x = samples[i];
+        double old = delay[position];
+        delay[position] = x;
+        position = (position + 1) % window;
+
+        for(int k = 0; k < tones; ++k) {
+
+            double re = x + stepRe[k] * stateRe[k] - stepIm[k] * stateIm[k] - lastRe[k] * old;
+            double im = stepRe[k] * stateIm[k] + stepIm[k] * stateRe[k] - lastIm[k] * old;
+            stateRe[k] = re;
+            stateIm[k] = im;
+
+            double rr = rotorRe[k] * turnRe[k] - rotorIm[k] * turnIm[k];
+            double ri = rotorRe[k] * turnIm[k] + rotorIm[k] * turnRe[k];
+            rotorRe[k] = rr;
+            rotorIm[k] = ri;
+        }
+
+        if(++block >= blockSize) {
+
+            block = 0;
+            emitBlock(sample + i + 1);
+        }
+    }
+
+    sample += n;
+}
+
+/* `index` counts the samples processed so far. */
+void ToneTracker::emitBlock(qint64 index) {
+
+    for(int k = 0; k < tones; ++k) {
+
+        /* keeping the rotor on the unit circle */
+        double norm = 1 / sqrt(rotorRe[k] * rotorRe[k] + rotorIm[k] * rotorIm[k]);
+        rotorRe[k] *= norm;
+        rotorIm[k] *= norm;
+
+        double re = stateRe[k] * rotorRe[k] - stateIm[k] * rotorIm[k];
+        double im = stateRe[k] * rotorIm[k] + stateIm[k] * rotorRe[k];
+
+        amplitude[k] = active[k] ? 20 * log10(2 * sqrt(re * re + im * im) / window + 1e-9) : TONE_FLOOR;
+        phase[k] = active[k] ? atan2(im, re) : 0;
+    }
+
+    emit updated(amplitude, phase);
+
+    if(log.isOpen()) {
+
+        logStream << (qint64) (origin + 1000.0 * index / rate) << "," << index;
+
+        for(int k = 0; k < tones; ++k) {
+
+            if(active[k]) {
+
+                logStream << "," << amplitude[k] << "," << phase[k];
+            }
+
+            else {
+
+                logStream << ",,";
+            }
+        }
+
+        logStream << "\n";
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef TONETRACKER_H
+#define TONETRACKER_H
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include <QObject>
+#include <QList>
+#include <QFile>
+#include <QTextStream>
+#include <QDateTime>
+
+#define TONE_WINDOW 0.0464     // seconds, 256 samples at 5512.5 Hz
+#define TONE_BLOCK 0.0058      // seconds between updates, 32 samples at 5512.5 Hz
+#define TONE_DAMPING 0.95      // per second of signal
+#define TONE_FLOOR -180        // dB reported for silence and for tones above Nyquist
+#define TONE_RESYNC_MS 1000    // samples arriving this late start a new time origin
+
+/* Sliding DFT over a few arbitrary frequencies, updated every sample.
+ *
+ * For each tone the state S(n) = x(n) + w S(n-1) - w^N x(n-N), with
+ * w = r e^(j 2 pi f / fs), is the DFT of the last N samples at f. It costs
+ * O(tones) per sample; r slightly below 1 keeps rounding errors from piling up.
+ * N, the update interval and r follow from seconds at the current rate, so
+ * the resolution and the update rate do not depend on the station.
+ * Every TONE_BLOCK seconds the amplitude (dB) and the phase relative to the
+ * nominal tone are emitted, and logged as CSV when a log file is set. Log lines
+ * carry the sample index and the time it implies at the sample rate, counted
+ * from an origin taken when samples start arriving and again after a gap.
+ * Tones at or above half the current sample rate stay in the output, at
+ * TONE_FLOOR and with empty log fields, until a faster stream is announced. */
+class ToneTracker : public QObject {
+
+    Q_OBJECT
+
+public slots:
+
+    void process(const int16_t*, int);
+    void setSampleRate(double);
+
+signals:
+
+    void updated(const double*, const double*);
+
+public:
+
+    ToneTracker(double, QList<double>);
+    ~ToneTracker();
+
+    bool setLog(QString);
+
+private:
+
+    void emitBlock(qint64);
+
+    int tones;
+    unsigned int position, block, window, blockSize;
+    qint64 sample;
+    double rate, origin;
+
+    double *stepRe, *stepIm;        // w
+    double *lastRe, *lastIm;        // w^N
+    double *stateRe, *stateIm;      // S(n)
+    double *rotorRe, *rotorIm;      // e^(-j 2 pi f n / fs)
+    double *turnRe, *turnIm;        // e^(-j 2 pi f / fs)
+    double *amplitude, *phase;
+    bool *active;
+
+    float *delay;
+
+    QList<double> frequencies;
+    QFile log;
+    QTextStream logStream;
+};
+
+#endif // TONETRACKER_H